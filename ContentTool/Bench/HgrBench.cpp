@@ -0,0 +1,452 @@
+// Throughput of the .hgr pipeline stage by stage, on synthetic files from SyntheticHgr.cpp, so no game
+// data is needed. Build it through the HgrBench target of CMakeLists.txt.
+//
+//   HgrBench [--versions 170,185,190,192,193 | all] [--primitives N] [--verts N] [--nodes N]
+//            [--animations N] [--keys N] [--repeat N] [--keep DIR]
+//   HgrBench --generate FILE [--version V] [--bad-indices N] [--truncate BYTES] [counts as above]
+//
+// Each stage is timed on its own, best of --repeat runs:
+//   file read        map the file and touch every byte
+//   section parse    index the sections, then materials, nodes and user properties
+//   vertex decode    the primitives section (stream views + build_geometry)
+//   keyframe decode  the transform animations section
+//   scene build      CreateFBX up to the save     (builds with the FBX exporter only)
+//   file write       the FBX save                 (builds with the FBX exporter only)
+//
+// Bone indices have to decode to the integers the streams hold, 8-bit and 5:5:5:1 alike, and the
+// keyframe tracks the exporter animates (position_keys, rotation quaternions, scale_keys) have to
+// hold every key of every animation, optimized or not. Every file is also written back with
+// hgr::write and has to come out byte for byte the same. A copy with indices past the vertices has
+// to load with them patched only when it is named like a known corrupt level, and truncated versions
+// of the file and a garbage file with its header have to be rejected by StoreData and SectionLoader.
+#include "SyntheticHgr.h"
+#include "../ToolCommon.h"
+#include "../HGR/HGR.h"
+#include "../HGR/HGRWriter.h"
+#include "../Common/MappedFile.h"
+#if TOOLS_WITH_FBX
+#include "../FBXExporter.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace tools;
+namespace fs = std::filesystem;
+
+namespace {
+    enum Stage {
+        STAGE_READ,
+        STAGE_PARSE,
+        STAGE_VERTICES,
+        STAGE_KEYFRAMES,
+        STAGE_SCENE,
+        STAGE_WRITE,
+
+        STAGE_COUNT
+    };
+
+    constexpr const char* STAGE_NAMES[STAGE_COUNT]{
+        "file read", "section parse", "vertex decode", "keyframe decode", "scene build", "file write"
+    };
+
+    constexpr const char* STAGE_ITEMS[STAGE_COUNT]{ "files", "nodes", "verts", "keys", "nodes", "files" };
+
+    struct stage_result {
+        f64     seconds{ std::numeric_limits<f64>::infinity() }; // best run
+        u64     bytes{};
+        u64     items{};
+        bool    ran{ false };
+    };
+
+    struct options {
+        bench::synthetic_hgr    params{};
+        std::vector<u16>        versions{ 170, 180, 185, 190, 192, 193 };
+        u32                     repeats{ 5 };
+        std::string             keepDir{}; // empty: a temporary directory
+        std::string             generate{}; // only write this file
+    };
+
+    void usage() {
+        std::fprintf(stderr,
+            "usage: HgrBench [--versions 170,185,... | all] [--primitives N] [--verts N] [--nodes N]\n"
+            "                [--animations N] [--keys N] [--repeat N] [--keep DIR]\n"
+            "       HgrBench --generate FILE [--version V] [--bad-indices N] [--truncate BYTES] [counts as above]\n");
+    }
+
+    bool parse_u32(const char* text, u32& value) {
+        char* end{ nullptr };
+        const unsigned long v = std::strtoul(text, &end, 10);
+        if (end == text || *end) return false;
+        value = u32(v);
+        return true;
+    }
+
+    bool parse_versions(std::string_view list, std::vector<u16>& versions) {
+        versions.clear();
+        if (list == "all") {
+            for (u16 v{ MINVERSION };v <= MAXVERSION;++v) versions.push_back(v);
+            return true;
+        }
+        while (!list.empty()) {
+            const size_t comma = std::min(list.find(','), list.size());
+            u32 v{ 0 };
+            if (!parse_u32(std::string(list.substr(0, comma)).c_str(), v) || v < MINVERSION || v > MAXVERSION) return false;
+            versions.push_back(u16(v));
+            list.remove_prefix(std::min(comma + 1, list.size()));
+        }
+        return !versions.empty();
+    }
+
+    bool parse_args(int argc, char** argv, options& opt) {
+        for (int i{ 1 };i < argc;++i) {
+            const std::string_view arg = argv[i];
+            if (i + 1 >= argc) return false;
+            const char* v = argv[++i];
+
+            u32 version{ 0 };
+            if (arg == "--versions") { if (!parse_versions(v, opt.versions)) return false; }
+            else if (arg == "--version") {
+                if (!parse_u32(v, version) || version < MINVERSION || version > MAXVERSION) return false;
+                opt.versions = { u16(version) };
+            }
+            else if (arg == "--primitives") { if (!parse_u32(v, opt.params.primitives)) return false; }
+            else if (arg == "--verts") { if (!parse_u32(v, opt.params.verts)) return false; }
+            else if (arg == "--nodes") { if (!parse_u32(v, opt.params.nodes)) return false; }
+            else if (arg == "--animations") { if (!parse_u32(v, opt.params.animations)) return false; }
+            else if (arg == "--keys") { if (!parse_u32(v, opt.params.keys)) return false; }
+            else if (arg == "--repeat") { if (!parse_u32(v, opt.repeats) || !opt.repeats) return false; }
+            else if (arg == "--keep") opt.keepDir = v;
+            else if (arg == "--generate") opt.generate = v;
+            else if (arg == "--bad-indices") { if (!parse_u32(v, opt.params.badIndices)) return false; }
+            else if (arg == "--truncate") {
+                u32 bytes{ 0 };
+                if (!parse_u32(v, bytes)) return false;
+                opt.params.truncate = bytes;
+            }
+            else return false;
+        }
+        return true;
+    }
+
+    using steady = std::chrono::steady_clock;
+
+    f64 since(steady::time_point start) { return std::chrono::duration<f64>(steady::now() - start).count(); }
+
+    void record(stage_result& stage, f64 seconds, u64 bytes, u64 items) {
+        stage.seconds = std::min(stage.seconds, seconds);
+        stage.bytes = bytes;
+        stage.items = items;
+        stage.ran = true;
+    }
+
+    u64 keyframe_count(const hgr::assetData& asset) {
+        u64 keys{ 0 };
+        for (u32 i{ 0 };i < asset.entityInfo->TransformAnimation_Count;++i) {
+            const hgr::transformAnimation& a = asset.transAnim[i];
+            for (const hgr::keyframeSequence* s : { a.posKeyData_uo, a.rotKeyData, a.sclKeyData_uo }) {
+                if (s) keys += s->keys.size();
+            }
+            for (const hgr::float3Animation* s : { a.posKeyData, a.sclKeyData }) {
+                if (s) keys += s->keys.size();
+            }
+        }
+        return keys;
+    }
+
+    // Number of animations whose position, rotation and scale tracks all reach the exporter with
+    // 'keys' keys each. The rotation is only animated from quaternions.
+    u32 exported_tracks(const hgr::assetData& asset, u32 keys) {
+        u32 complete{ 0 };
+        for (u32 i{ 0 };i < asset.entityInfo->TransformAnimation_Count;++i) {
+            const hgr::transformAnimation& a = asset.transAnim[i];
+            const bool rotation = a.rotKeyData && a.rotKeyData->dataFormat == VertexFormat::DF_V4_32 &&
+                                  a.rotKeyData->keys.size() == keys;
+            if (rotation && hgr::position_keys(a).size() == keys && hgr::scale_keys(a).size() == keys) ++complete;
+        }
+        return complete;
+    }
+
+    // Number of primitives whose decoded bone indices are the integers of their stream, out of 'skinned'.
+    // Undoes the normalization of the 8-bit and 5:5:5:1 formats in build_geometry.
+    u32 bone_indices(const hgr::assetData& asset, u32& skinned) {
+        using geometry = hgr::primitive_geometry;
+        u32 exact{ 0 };
+        skinned = 0;
+        for (const hgr::primitive_info& p : asset.primInfo) {
+            if (!p.layout.has(VertexFormat::DT_BONEINDICES)) continue;
+            ++skinned;
+
+            const hgr::vertArray& stream = p.vArray[p.layout.stream[VertexFormat::DT_BONEINDICES]];
+            const bool packed = stream.format == VertexFormat::DF_V4_5;
+            if (!packed && stream.format != VertexFormat::DF_V4_8) continue;
+
+            bool same{ p.geometry.has(geometry::BONEINDICES) };
+            for (u32 v{ 0 };v < p.verts && same;++v) {
+                for (u32 k{ 0 };k < 4;++k) { // w of the packed format is its top bit
+                    const u32 bone = packed ? (stream.as<u16>()[v] >> (5 * k)) & (k < 3 ? 31 : 1) : stream.as<u8>()[v * 4 + k];
+                    same = same && p.geometry.get(geometry::BONEINDICES, k)[v] == f32(bone) && bone < p.usedBoneCount;
+                }
+            }
+            if (same) ++exact;
+        }
+        return exact;
+    }
+
+    // Loads the primitives of 'path' and counts the indices past their primitive's vertices
+    bool indices_past_vertices(const fs::path& path, u64& past) {
+        hgr::SectionLoader loader{};
+        if (!loader.open(path.string().c_str()) || !loader.load(hgr::SECTION_PRIMITIVES)) return false;
+        past = 0;
+        for (const hgr::primitive_info& p : loader.asset().primInfo) {
+            for (u32 i{ 0 };i < p.indices;++i) past += p.indexData[i] >= p.verts;
+        }
+        return true;
+    }
+
+    // Writes 'params' with 'bad' indices past the vertices of each primitive, once under a plain name and
+    // once as a known corrupt level, and checks that only the corrupt level gets its indices patched
+    bool corrupt_patch(bench::synthetic_hgr params, const fs::path& dir, u32 bad) {
+        params.badIndices = bad;
+        const fs::path plain = dir / "bad_indices.hgr";
+        const fs::path level = dir / "worldmap.hgr"; // in is_known_corrupt()'s list
+        u64 plainPast{ 0 }, levelPast{ u64_invalid_id };
+        const bool ok = bench::write_hgr(plain, params) && bench::write_hgr(level, params) &&
+                        indices_past_vertices(plain, plainPast) && indices_past_vertices(level, levelPast);
+
+        std::error_code ec{};
+        fs::remove(plain, ec);
+        fs::remove(level, ec);
+        return ok && plainPast && !levelPast;
+    }
+
+    // Loads 'path' and writes it back, returns the offset of the first byte that differs or
+    // u64_invalid_id if both are the same
+    u64 round_trip(const fs::path& path) {
+        hgr::SectionLoader loader{};
+        MappedFile original{};
+        std::vector<u8> written;
+        if (!loader.open(path.string().c_str()) || !original.open(path)) return 0;
+        for (u32 s{ 0 };s < hgr::SECTION_COUNT;++s) {
+            if (!loader.load(hgr::Section(s))) return 0;
+        }
+        if (!hgr::write(loader.asset(), written)) return 0;
+
+        const u64 size = std::min<u64>(written.size(), original.size());
+        const u64 at = u64(std::mismatch(written.begin(), written.begin() + size, original.data()).first - written.begin());
+        return (at == size && written.size() == original.size()) ? u64_invalid_id : at;
+    }
+
+    // True if neither StoreData nor the SectionLoader accept 'path'
+    bool rejects(const fs::path& path, const fs::path& outDir) {
+        const std::string file = path.string();
+        const std::string out = outDir.string();
+        if (hgr::StoreData(file.c_str(), out.c_str(), out.c_str())) return false;
+
+        hgr::SectionLoader loader{};
+        if (!loader.open(file.c_str())) return true;
+        for (u32 s{ 0 };s < hgr::SECTION_COUNT;++s) {
+            if (!loader.load(hgr::Section(s))) return true;
+        }
+        return false;
+    }
+
+    bool write_bytes(const fs::path& path, const u8* data, u64 size) {
+        std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+        out.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+        return bool(out);
+    }
+
+    // Feeds 'params' truncated at 'cuts' offsets, then a file whose body past the header is noise,
+    // to rejects(). Returns how many were rejected out of 'tried'.
+    u32 bad_input(bench::synthetic_hgr params, const fs::path& outDir, u32 cuts, u32& tried) {
+        std::vector<u8> original = bench::generate_hgr(params);
+        const fs::path bad = outDir / "bad.hgr";
+        u32 rejected{ 0 };
+        tried = 0;
+
+        for (u32 c{ 0 };c < cuts;++c) {
+            params.truncate = original.size() * c / cuts;
+            if (!bench::write_hgr(bad, params)) continue;
+            ++tried;
+            if (rejects(bad, outDir)) ++rejected;
+        }
+
+        // Same seed every run, the same garbage
+        constexpr u64 HEADER_BYTES{ 40 };
+        std::vector<u8> garbage = original;
+        u32 seed{ 0x9e3779b9u };
+        for (u64 i{ std::min<u64>(HEADER_BYTES, garbage.size()) };i < garbage.size();++i) {
+            seed = seed * 1664525u + 1013904223u;
+            garbage[i] = u8(seed >> 24);
+        }
+        if (write_bytes(bad, garbage.data(), garbage.size())) {
+            ++tried;
+            if (rejects(bad, outDir)) ++rejected;
+        }
+
+        std::error_code ec{};
+        fs::remove(bad, ec);
+        return rejected;
+    }
+
+    struct checks {
+        u32     tracks{}; // exported_tracks()
+        u32     bones{}; // bone_indices()
+        u32     skinned{};
+    };
+
+    // One run of every stage over 'path', keeps the best time of each
+    bool run_once(const fs::path& path, const fs::path& outDir, u32 keys, stage_result (&stages)[STAGE_COUNT], checks& check) {
+        const std::string file = path.string();
+
+        auto start = steady::now();
+        {
+            MappedFile mapped{};
+            if (!mapped.open(path)) return false;
+            u64 sum{ 0 };
+            for (u64 i{ 0 };i < mapped.size();++i) sum += mapped.data()[i];
+            volatile u64 sink = sum; (void)sink;
+            record(stages[STAGE_READ], since(start), mapped.size(), 1);
+        }
+
+        hgr::SectionLoader loader{};
+        start = steady::now();
+        if (!loader.open(file.c_str())) return false;
+        if (!loader.load(hgr::SECTION_MATERIALS) || !loader.load_nodes() || !loader.load(hgr::SECTION_USERPROPERTIES)) return false;
+        const f64 parse = since(start);
+
+        const hgr::section_index& index = loader.index();
+        const u64 vertexBytes = index.sections[hgr::SECTION_PRIMITIVES].size;
+        const u64 keyBytes = index.sections[hgr::SECTION_TRANSFORMANIMATIONS].size;
+        const u64 fileBytes = fs::file_size(path);
+        const u32 nodes = loader.asset().Nodes.size();
+        record(stages[STAGE_PARSE], parse, fileBytes - vertexBytes - keyBytes, nodes);
+
+        start = steady::now();
+        if (!loader.load(hgr::SECTION_PRIMITIVES)) return false;
+        record(stages[STAGE_VERTICES], since(start), vertexBytes, index.vertexCount);
+        check.bones = bone_indices(loader.asset(), check.skinned);
+
+        start = steady::now();
+        if (!loader.load(hgr::SECTION_TRANSFORMANIMATIONS)) return false;
+        record(stages[STAGE_KEYFRAMES], since(start), keyBytes, keyframe_count(loader.asset()));
+        check.tracks = exported_tracks(loader.asset(), keys);
+
+#if TOOLS_WITH_FBX
+        fbx_timings fbx{};
+        if (!CreateFBX(loader.asset(), file.c_str(), outDir.string().c_str(), outDir.string().c_str(), &fbx)) return false;
+
+        // CreateFBX names the output after the input's stem
+        std::error_code ec{};
+        u64 written = fs::file_size(outDir / path.stem(), ec);
+        if (ec) written = fs::file_size(fs::path(outDir / path.stem()).concat(".fbx"), ec);
+        record(stages[STAGE_SCENE], fbx.sceneBuild, fileBytes, nodes);
+        record(stages[STAGE_WRITE], fbx.fileWrite, ec ? 0 : written, 1);
+#else
+        (void)outDir;
+#endif
+        return true;
+    }
+
+    void print_rate(f64 amount, f64 seconds, const char* unit) {
+        const f64 rate = seconds > 0.0 ? amount / seconds : 0.0;
+        if (rate >= 1e9) std::printf(" %10.2f G%s/s", rate / 1e9, unit);
+        else if (rate >= 1e6) std::printf(" %10.2f M%s/s", rate / 1e6, unit);
+        else if (rate >= 1e3) std::printf(" %10.2f k%s/s", rate / 1e3, unit);
+        else std::printf(" %10.2f  %s/s", rate, unit);
+    }
+
+    void print(const stage_result (&stages)[STAGE_COUNT]) {
+        std::printf("  %-16s %10s %12s   %s\n", "stage", "ms", "MB/s", "items/s");
+        for (u32 s{ 0 };s < STAGE_COUNT;++s) {
+            const stage_result& r = stages[s];
+            if (!r.ran) {
+                std::printf("  %-16s %10s\n", STAGE_NAMES[s], "-");
+                continue;
+            }
+            std::printf("  %-16s %10.3f %12.1f  ", STAGE_NAMES[s], r.seconds * 1e3, r.seconds > 0.0 ? r.bytes / r.seconds / 1e6 : 0.0);
+            print_rate(f64(r.items), r.seconds, STAGE_ITEMS[s]);
+            std::printf("\n");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    options opt{};
+    if (!parse_args(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    if (!opt.generate.empty()) {
+        opt.params.version = opt.versions.back();
+        if (!bench::write_hgr(opt.generate, opt.params)) {
+            std::fprintf(stderr, "HgrBench: can't write %s\n", opt.generate.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    std::error_code ec{};
+    const fs::path dir = opt.keepDir.empty() ? fs::temp_directory_path(ec) / "HgrBench" : fs::path(opt.keepDir);
+    fs::create_directories(dir, ec);
+
+    std::printf("%u primitives x %u verts, %u nodes, %u animations x %u keys, best of %u\n",
+                opt.params.primitives, opt.params.verts, opt.params.nodes, opt.params.animations, opt.params.keys, opt.repeats);
+#if !TOOLS_WITH_FBX
+    std::printf("built without the FBX exporter, scene build and file write are skipped\n");
+#endif
+
+    bool ok{ true };
+    for (u16 version : opt.versions) {
+        bench::synthetic_hgr params = opt.params;
+        params.version = version;
+
+        const fs::path path = dir / ("synthetic_" + std::to_string(version) + ".hgr");
+        if (!bench::write_hgr(path, params)) {
+            std::fprintf(stderr, "HgrBench: can't write %s\n", path.string().c_str());
+            return 1;
+        }
+
+        stage_result stages[STAGE_COUNT]{};
+        checks check{};
+        bool runs{ true };
+        for (u32 r{ 0 };r < opt.repeats && runs;++r) runs = run_once(path, dir, params.keys, stages, check);
+
+        std::printf("\nversion %u, %.2f MB%s\n", version, fs::file_size(path, ec) / 1e6, runs ? "" : ", FAILED to load");
+        if (runs) print(stages);
+
+        const u32 animations = std::min(params.animations, params.nodes);
+        if (runs) {
+            std::printf("  bone indices     %u/%u primitives decoded\n", check.bones, check.skinned);
+            std::printf("  keyframe tracks  %u/%u animations exported\n", check.tracks, animations);
+        }
+        runs = runs && check.bones == check.skinned && check.tracks == animations;
+
+        const u64 differs = round_trip(path);
+        if (differs == u64_invalid_id) std::printf("  round trip       exact\n");
+        else std::printf("  round trip       FAILED, differs at byte %llu\n", (unsigned long long)differs);
+
+        const bool patched = corrupt_patch(params, dir, 5);
+        std::printf("  corrupt indices  %s\n", patched ? "patched" : "FAILED");
+
+        u32 tried{ 0 };
+        const u32 rejected = bad_input(params, dir, 16, tried);
+        std::printf("  bad input        %u/%u rejected\n", rejected, tried);
+
+        ok = ok && runs && differs == u64_invalid_id && patched && tried && rejected == tried;
+    }
+
+    if (opt.keepDir.empty()) fs::remove_all(dir, ec);
+    return ok ? 0 : 1;
+}
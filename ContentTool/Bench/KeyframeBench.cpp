@@ -0,0 +1,108 @@
+// Micro-benchmark: quantized keyframe decoding, the old per-component loop from read_Float4Array16 /
+// read_Float3Array16 against the bulk dequantize_u16_keys kernels. Not part of the DLL, build it on its own
+// from the ContentTool directory:
+//   cl /O2 /EHsc /std:c++20 Bench\KeyframeBench.cpp Common\Dequantize.cpp
+// or through the KeyframeBench target of CMakeLists.txt.
+#include "../Common/Dequantize.h"
+#include "../Common/Math.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string.h>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+    // What the parser did before the kernels: a memcpy and a multiply-add per component, then emplace_back
+    std::vector<math::float4> decode_reference(const u8* at, s32 count, u32 dim, const f32* minv, const f32* maxv) {
+        std::vector<math::float4> out;
+        out.reserve(count);
+
+        f32 delta[4]{};
+        for (u32 k{ 0 };k < dim;++k) delta[k] = maxv[k] - minv[k];
+
+        for (int i = 0; i < count; ++i) {
+            f32 zeta[4]{};
+            for (u32 k{ 0 };k < dim;++k) {
+                u16 xi; float x;
+                memcpy(&xi, at, sizeof(u16)); at += sizeof(u16);
+
+                x = float(xi) * (1.f / 65535.f);
+                x *= delta[k];
+                x += minv[k];
+                zeta[k] = x;
+            }
+            out.emplace_back(zeta[0], zeta[1], zeta[2], zeta[3]);
+        }
+        return out;
+    }
+
+    template<typename F>
+    f64 seconds(u32 repeats, F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (u32 r{ 0 };r < repeats;++r) f();
+        return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* level_name(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::SSE2:   return "SSE2";
+        case SimdLevel::Scalar: return "scalar";
+        }
+        return "?";
+    }
+}
+
+int main() {
+    // Roughly one animation-heavy level: lots of short tracks
+    constexpr u32 tracks{ 4000 };
+    constexpr u32 keysPerTrack{ 250 };
+    constexpr u32 repeats{ 20 };
+
+    std::mt19937 rng{ 193 };
+    std::vector<u8> data(tracks * keysPerTrack * 4 * sizeof(u16) + 1); // +1 so the keys start misaligned
+    for (u8& b : data) b = u8(rng());
+
+    const f32 minv[4]{ -1.f, -2.f, -3.f, -4.f };
+    const f32 maxv[4]{ 1.f, 2.f, 3.f, 4.f };
+
+    std::printf("kernels: %s\n", level_name(simd_level()));
+
+    for (u32 dim : { 3u, 4u }) {
+        const u32 trackBytes = keysPerTrack * dim * sizeof(u16);
+        std::vector<math::float4> keys(keysPerTrack);
+
+        // Both paths have to agree exactly before their speed matters
+        for (u32 t{ 0 };t < tracks;++t) {
+            const u8* src = data.data() + 1 + t * trackBytes;
+            auto expected = decode_reference(src, keysPerTrack, dim, minv, maxv);
+            dequantize_u16_keys(src, keysPerTrack, dim, minv, maxv, reinterpret_cast<f32*>(keys.data()));
+            if (memcmp(expected.data(), keys.data(), sizeof(math::float4) * keysPerTrack) != 0) {
+                std::printf("dim %u: track %u differs from the reference\n", dim, t);
+                return 1;
+            }
+        }
+
+        volatile f32 sink{ 0.f };
+        const f64 reference = seconds(repeats, [&]() {
+            for (u32 t{ 0 };t < tracks;++t) {
+                auto out = decode_reference(data.data() + 1 + t * trackBytes, keysPerTrack, dim, minv, maxv);
+                sink = sink + out.back().x;
+            }
+        });
+        const f64 bulk = seconds(repeats, [&]() {
+            for (u32 t{ 0 };t < tracks;++t) {
+                dequantize_u16_keys(data.data() + 1 + t * trackBytes, keysPerTrack, dim, minv, maxv, reinterpret_cast<f32*>(keys.data()));
+                sink = sink + keys.back().x;
+            }
+        });
+
+        const f64 total = f64(tracks) * keysPerTrack * repeats;
+        std::printf("dim %u: reference %8.1f Mkeys/s | bulk %8.1f Mkeys/s | x%.1f\n",
+                    dim, total / reference / 1e6, total / bulk / 1e6, reference / bulk);
+    }
+    return 0;
+}
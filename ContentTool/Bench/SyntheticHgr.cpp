@@ -0,0 +1,416 @@
+#include "SyntheticHgr.h"
+#include "../ToolCommon.h"
+#include "../HGR/HGR.h"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace tools::bench {
+
+    namespace {
+        using namespace tools::hgr;
+        using namespace tools::VertexFormat;
+
+        // Counts and most scalars are big-endian in the file. Vertex, index and quantized key data,
+        // the header fields and the fog parameters are read as they are (little-endian).
+        class hgr_writer {
+        public:
+            explicit hgr_writer(std::vector<u8>& out) : _out{ out } {}
+
+            template<typename T> void be(T v) { SWAP(v, T); raw(&v, sizeof(T)); }
+            template<typename T> void le(T v) { raw(&v, sizeof(T)); }
+
+            void raw(const void* data, size_t bytes) {
+                const u8* p = static_cast<const u8*>(data);
+                _out.insert(_out.end(), p, p + bytes);
+            }
+
+            void zeros(size_t bytes) { _out.resize(_out.size() + bytes); }
+
+            void str(std::string_view s) {
+                be<u16>(u16(s.size()));
+                raw(s.data(), s.size());
+            }
+
+            void check_id() { be<u32>(++_checkId); }
+            void first_check_id() { be<u32>(_checkId); }
+
+        private:
+            std::vector<u8>&    _out;
+            u32                 _checkId{ 0x12345600 };
+        };
+
+        struct node_counts {
+            u32     meshes{};
+            u32     cameras{};
+            u32     lights{};
+            u32     dummies{};
+            u32     shapes{};
+            u32     others{};
+        };
+
+        node_counts split_nodes(const synthetic_hgr& params) {
+            node_counts n{};
+            n.meshes = std::min(params.primitives, (params.nodes + 1) / 2);
+            u32 rest = params.nodes - n.meshes;
+            n.cameras = std::min(rest, 1u);
+            rest -= n.cameras;
+            n.lights = rest / 8;
+            n.dummies = rest / 8;
+            n.shapes = rest / 16;
+            n.others = rest - n.lights - n.dummies - n.shapes;
+            return n;
+        }
+
+        std::string node_name(u32 i) { return "node" + std::to_string(i); }
+
+        constexpr u32 MESH_BONES{ 8 };
+
+        class generator {
+        public:
+            generator(const synthetic_hgr& params, std::vector<u8>& out)
+                : _p{ params }, _w{ out }, _rng{ params.seed * 1000u + params.version } {
+                _p.version = std::clamp<u16>(_p.version, MINVERSION, MAXVERSION);
+                _p.materials = std::max(_p.materials, 1u);
+                _p.animations = std::min(_p.animations, _p.nodes);
+
+                // u16 indices, and before 190 the index count itself is 16-bit
+                _p.verts = std::min(_p.verts, _p.version < 190 ? 21847u : 65535u);
+                _nodes = split_nodes(_p);
+            }
+
+            void run() {
+                header();
+                materials();
+                _w.check_id(); primitives();
+                _w.check_id(); meshes();
+                _w.check_id(); cameras();
+                _w.check_id(); lights();
+                _w.check_id(); dummies();
+                _w.check_id(); shapes();
+                _w.check_id(); other_nodes();
+                _w.check_id(); animations();
+                _w.check_id(); user_properties();
+            }
+
+        private:
+            f32 random(f32 lo, f32 hi) { return std::uniform_real_distribution<f32>{ lo, hi }(_rng); }
+
+            void random_bytes(size_t bytes) {
+                for (size_t i{ 0 };i < bytes;i += sizeof(u32)) {
+                    const u32 r = _rng();
+                    _w.raw(&r, std::min(bytes - i, sizeof(u32)));
+                }
+            }
+
+            void header() {
+                _w.raw("hgrfi", 5);
+                _w.le<u8>(u8(_p.version));
+                _w.le<u32>(0x020903); // exporter version
+                _w.le<u16>(DATA_MATERIALS | DATA_PRIMITIVES | DATA_NODES | DATA_ANIMATIONS | DATA_USERPROPERTIES);
+                _w.le<u16>(1); // platform
+
+                _w.le<u8>(1); // fog type
+                _w.le<f32>(10.f);
+                _w.le<f32>(1000.f);
+                for (f32 c : { 0.5f, 0.6f, 0.7f }) _w.le<f32>(c);
+                _w.first_check_id();
+            }
+
+            void materials() {
+                _w.be<u32>(_p.textures);
+                for (u32 i{ 0 };i < _p.textures;++i) {
+                    _w.str("texture" + std::to_string(i) + ".ntx");
+                    _w.le<s32>(0);
+                }
+
+                _w.be<u32>(_p.materials);
+                for (u32 i{ 0 };i < _p.materials;++i) {
+                    _w.str("material" + std::to_string(i));
+                    _w.str("basic");
+                    _w.be<s32>(-1); // no lightmap
+
+                    _w.le<u8>(_p.textures ? 1 : 0);
+                    if (_p.textures) {
+                        _w.str("BASEMAP");
+                        _w.be<u16>(u16(i % _p.textures));
+                    }
+                    _w.le<u8>(2);
+                    _w.str("AMBIENTC");
+                    for (f32 c : { 0.2f, 0.2f, 0.2f, 1.f }) _w.be<f32>(c);
+                    _w.str("DIFFUSEC");
+                    for (u32 k{ 0 };k < 4;++k) _w.be<f32>(random(0.f, 1.f));
+                    _w.le<u8>(1);
+                    _w.str("SHININESS");
+                    _w.be<f32>(16.f);
+                }
+            }
+
+            void stream(DataType type, DataFormat format) {
+                _w.str(toString(type));
+                _w.str(toString(format));
+            }
+
+            void primitives() {
+                const bool quantized = _p.version >= 190;
+                const u32 verts = _p.verts;
+                const u32 indices = verts >= 3 ? (verts - 2) * 3 : 0;
+
+                _w.be<u32>(_p.primitives);
+                for (u32 i{ 0 };i < _p.primitives;++i) {
+                    const bool skinned = (i % 4) == 3;
+
+                    if (quantized) { _w.be<u32>(verts); _w.be<u32>(indices); }
+                    else { _w.be<u16>(u16(verts)); _w.be<u16>(u16(indices)); }
+
+                    const bool packed = (i % 8) == 7; // skinned with the 16-bit and 5:5:5:1 formats
+                    struct { DataType type; DataFormat format; } streams[6]{
+                        { DT_POSITION, quantized ? DF_V3_16 : DF_V3_32 },
+                        { DT_NORMAL, DF_V3_8 },
+                        { DT_TEX0, quantized ? DF_V2_16 : DF_V2_32 },
+                        { DT_DIFFUSE, (i % 2) ? DF_V4_5 : DF_V4_8 },
+                        { DT_BONEWEIGHTS, packed ? DF_V4_16 : DF_V4_8 },
+                        { DT_BONEINDICES, packed ? DF_V4_5 : DF_V4_8 },
+                    };
+                    const u8 usedBones = skinned ? u8(std::min(MESH_BONES, 3 + i % 6)) : 0;
+                    const u8 streamCount = skinned ? 6 : 4;
+
+                    _w.le<u8>(streamCount);
+                    for (u8 s{ 0 };s < streamCount;++s) stream(streams[s].type, streams[s].format);
+
+                    _w.be<u16>(u16(i % _p.materials));
+                    _w.be<u16>(3); // triangle list
+
+                    if (quantized) {
+                        for (f32 v : { 1.f / 256.f, 0.f, 0.f, 0.f }) _w.be<f32>(v); // posscalebias
+                        for (f32 v : { 1.f / 4096.f, 0.f, 0.f, 0.f }) _w.be<f32>(v); // uvscalebias
+                    }
+
+                    for (u8 s{ 0 };s < streamCount;++s) {
+                        if (!quantized) _w.zeros(sizeof(f32) * 5); // dummy scale + bias4
+
+                        const DataFormat df = streams[s].format;
+                        if (df == DF_V3_32) {
+                            for (u32 v{ 0 };v < verts * 3;++v) _w.le<f32>(random(-100.f, 100.f));
+                        }
+                        else if (df == DF_V2_32) {
+                            for (u32 v{ 0 };v < verts * 2;++v) _w.le<f32>(random(0.f, 1.f));
+                        }
+                        else if (df == DF_V2_16) {
+                            for (u32 v{ 0 };v < verts * 2;++v) _w.le<s16>(s16(_rng() & 0xfff));
+                        }
+                        else if (streams[s].type == DT_BONEINDICES && df == DF_V4_5) { // x, y, z, then bone 0 or 1 for w
+                            for (u32 v{ 0 };v < verts;++v) {
+                                u16 bits = u16((_rng() & 1) << 15);
+                                for (u32 k{ 0 };k < 3;++k) bits |= u16((_rng() % usedBones) << (5 * k));
+                                _w.le<u16>(bits);
+                            }
+                        }
+                        else if (streams[s].type == DT_BONEINDICES) { // into the used-bone table
+                            for (u32 v{ 0 };v < verts * 4;++v) _w.le<u8>(u8(_rng() % usedBones));
+                        }
+                        else {
+                            random_bytes(size_t(getDataSize(df)) * verts);
+                        }
+                    }
+
+                    // The corrupt levels have indices past the vertices, the reader patches them
+                    const u32 bad = std::min(_p.badIndices, indices);
+                    const u32 step = bad ? indices / bad : 1;
+                    for (u32 t{ 0 };t + 2 < verts;++t) {
+                        for (u32 k{ 0 };k < 3;++k) {
+                            const u32 n = t * 3 + k;
+                            const bool past = n % step == 0 && n / step < bad;
+                            _w.le<u16>(u16(past ? std::min(verts + n % 7, 65535u) : t + k));
+                        }
+                    }
+
+                    // Mesh bones used by this primitive, each mesh has MESH_BONES of them
+                    _w.le<u8>(usedBones);
+                    for (u8 b{ 0 };b < usedBones;++b) _w.le<u8>(u8((b * 3 + i) % MESH_BONES));
+                }
+            }
+
+            void node(u32 classId) {
+                const u32 i = _nextNode++;
+                _w.str(node_name(i));
+
+                for (u32 row{ 0 };row < 3;++row) { // x, y, z axes and the translation, row by row
+                    for (u32 col{ 0 };col < 3;++col) _w.be<f32>(row == col ? 1.f : 0.f);
+                    _w.be<f32>(random(-50.f, 50.f));
+                }
+
+                _w.be<u32>(classId | NODE_ENABLED);
+                _w.be<u32>(i); // id
+
+                // Parents always come earlier in the table, so the hierarchy has no cycles
+                _w.be<u32>((i == 0 || _rng() % 8 == 0) ? u32_invalid_id : u32(_rng() % i));
+            }
+
+            void meshes() {
+                _w.be<u32>(_nodes.meshes);
+                for (u32 m{ 0 };m < _nodes.meshes;++m) {
+                    node(NODE_MESH);
+
+                    // Primitive i goes to mesh i % meshes
+                    const u32 prims = (_p.primitives - m + _nodes.meshes - 1) / _nodes.meshes;
+                    _w.be<u32>(prims);
+                    for (u32 k{ 0 };k < prims;++k) _w.be<u32>(m + k * _nodes.meshes);
+
+                    // Bones for the skinned primitives (i % 4 == 3) among them
+                    bool skinned{ false };
+                    for (u32 k{ 0 };k < prims;++k) skinned = skinned || ((m + k * _nodes.meshes) % 4) == 3;
+                    const u32 bones = skinned ? MESH_BONES : 0;
+
+                    _w.be<u32>(bones);
+                    for (u32 b{ 0 };b < bones;++b) {
+                        _w.be<u32>((m + b + 1) % _p.nodes); // bone node
+                        for (u32 row{ 0 };row < 3;++row) { // inverse rest transform, row by row
+                            for (u32 col{ 0 };col < 3;++col) _w.be<f32>(row == col ? 1.f : 0.f);
+                            _w.be<f32>(random(-10.f, 10.f));
+                        }
+                    }
+                }
+            }
+
+            void cameras() {
+                _w.be<u32>(_nodes.cameras);
+                for (u32 i{ 0 };i < _nodes.cameras;++i) {
+                    node(NODE_CAMERA);
+                    for (f32 v : { 1.f, 5000.f, 1.2f }) _w.be<f32>(v); // front, back, FOV
+                }
+            }
+
+            void lights() {
+                _w.be<u32>(_nodes.lights);
+                for (u32 i{ 0 };i < _nodes.lights;++i) {
+                    node(NODE_LIGHT);
+                    for (u32 k{ 0 };k < 3;++k) _w.be<f32>(random(0.f, 1.f)); // colour
+                    for (f32 v : { 0.f, 0.f, 100.f, 200.f, 0.5f, 0.8f }) _w.be<f32>(v);
+                    _w.le<u8>(u8(TYPE_OMNI + i % 2));
+                }
+            }
+
+            void dummies() {
+                _w.be<u32>(_nodes.dummies);
+                for (u32 i{ 0 };i < _nodes.dummies;++i) {
+                    node(NODE_DUMMY);
+                    for (f32 v : { -1.f, -1.f, -1.f, 1.f, 1.f, 1.f }) _w.be<f32>(v); // box
+                }
+            }
+
+            void shapes() {
+                _w.be<u32>(_nodes.shapes);
+                for (u32 i{ 0 };i < _nodes.shapes;++i) {
+                    node(NODE_LINES);
+                    _w.be<s32>(2); // lines
+                    _w.be<s32>(1); // paths
+                    for (u32 k{ 0 };k < 12;++k) _w.be<f32>(random(-10.f, 10.f));
+                    _w.be<s32>(0);
+                    _w.be<s32>(1);
+                }
+            }
+
+            void other_nodes() {
+                _w.be<u32>(_nodes.others);
+                for (u32 i{ 0 };i < _nodes.others;++i) node(NODE_OTHER);
+            }
+
+            // read_Float4Array16 / read_Float3Array16: quantized from 3 keys on, plain floats below.
+            // A constant track (lo == hi) has zero words, the way the exporter writes it.
+            void float_array16(u32 dim, f32 lo, f32 hi) {
+                if (_p.keys > 2) {
+                    for (u32 k{ 0 };k < dim;++k) _w.be<f32>(lo);
+                    for (u32 k{ 0 };k < dim;++k) _w.be<f32>(hi);
+                    if (lo == hi) _w.zeros(sizeof(u16) * dim * _p.keys);
+                    else random_bytes(sizeof(u16) * dim * _p.keys);
+                }
+                else {
+                    for (u32 k{ 0 };k < dim * _p.keys;++k) _w.be<f32>(random(lo, hi));
+                }
+            }
+
+            // Pre-192 keyframe sequence: format name, scale and bias, then big-endian floats
+            void float_sequence(DataFormat df, f32 lo, f32 hi) {
+                _w.be<s32>(s32(_p.keys));
+                _w.str(toString(df));
+                _w.be<f32>(1.f);
+                for (u32 k{ 0 };k < 3;++k) _w.be<f32>(0.f);
+                for (u32 k{ 0 };k < getDataDim(df) * _p.keys;++k) _w.be<f32>(random(lo, hi));
+            }
+
+            // From 192 on a sequence is a dimension and a Float4Array16 / Float3Array16
+            void quantized_sequence(u32 dim, f32 lo, f32 hi) {
+                _w.be<s32>(s32(_p.keys));
+                _w.be<u32>(dim);
+                float_array16(dim, lo, hi);
+            }
+
+            void animations() {
+                _w.be<u32>(_p.animations);
+                for (u32 i{ 0 };i < _p.animations;++i) {
+                    // From 192 on every fourth animation is still stored as plain sequences
+                    const bool optimized = _p.version >= 192 && i % 4 != 1;
+                    const f32 scaleMax = (i % 5) == 2 ? 1.f : 2.f; // constant scale, an empty key range
+                    const f32 scaleMin = (i % 5) == 2 ? 1.f : 0.5f;
+
+                    _w.str(node_name(u32(u64(i) * _p.nodes / _p.animations)));
+                    for (u8 rate : { 30, 30, 30 }) _w.le<u8>(rate);
+                    _w.le<u8>(BEHAVIOUR_REPEAT);
+                    _w.le<u8>(optimized ? 1 : 0); // stepped over before 192
+
+                    if (!optimized && _p.version < 192) {
+                        float_sequence(DF_V3_32, -50.f, 50.f); // position
+                        float_sequence(DF_V4_32, -1.f, 1.f); // rotation
+                        float_sequence(DF_V3_32, scaleMin, scaleMax); // scale
+                        continue;
+                    }
+                    if (!optimized) {
+                        quantized_sequence(3, -50.f, 50.f);
+                        quantized_sequence(4, -1.f, 1.f);
+                        quantized_sequence(3, scaleMin, scaleMax);
+                        continue;
+                    }
+
+                    _w.be<s32>(s32(_p.keys)); float_array16(4, -50.f, 50.f); // position, read as 4 components
+                    _w.be<s32>(s32(_p.keys)); _w.be<u32>(4); float_array16(4, -1.f, 1.f); // rotation
+                    _w.be<s32>(s32(_p.keys)); float_array16(4, scaleMin, scaleMax); // scale
+                    if (_p.version >= 193) _w.be<f32>(f32(_p.keys) / 30.f); // end time
+                }
+            }
+
+            void user_properties() {
+                const u32 count = _p.nodes / 16;
+                _w.be<u32>(count);
+                for (u32 i{ 0 };i < count;++i) {
+                    _w.str(node_name(i * 16));
+                    _w.str("Time = 1\nParticle = \"fire\"");
+                }
+            }
+
+            synthetic_hgr       _p;
+            hgr_writer          _w;
+            std::mt19937        _rng;
+            node_counts         _nodes{};
+            u32                 _nextNode{ 0 };
+        };
+    }
+
+    std::vector<u8> generate_hgr(const synthetic_hgr& params) {
+        std::vector<u8> out;
+        generator{ params, out }.run();
+        if (params.truncate < out.size()) out.resize(size_t(params.truncate));
+        return out;
+    }
+
+    bool write_hgr(const std::filesystem::path& path, const synthetic_hgr& params) {
+        const std::vector<u8> data = generate_hgr(params);
+
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        return bool(file);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "../Common/PrimitiveTypes.h"
+#include <filesystem>
+#include <vector>
+
+namespace tools::bench {
+
+    // Shape of a generated file. The counts are totals, the generator spreads the nodes over the
+    // node classes (meshes first, one per primitive as far as they go) and the primitives over the meshes.
+    struct synthetic_hgr {
+        u16         version{ 193 }; // MINVERSION .. MAXVERSION
+        u32         textures{ 8 };
+        u32         materials{ 8 };
+        u32         primitives{ 64 };
+        u32         verts{ 2048 }; // per primitive, at most 65535
+        u32         nodes{ 256 };
+        u32         animations{ 64 }; // transform animations, one per node at most
+        u32         keys{ 256 }; // per track
+        u32         seed{ 1 };
+        u32         badIndices{ 0 }; // per primitive, past its vertices: only loads as a known corrupt level
+        u64         truncate{ u64_invalid_id }; // keep this many bytes, the rest of the file is missing
+    };
+
+    // Builds a valid .hgr file from random data, laid out the way the reader in HGR.cpp expects it for
+    // 'version': 16-bit counts and float streams before 190, quantized streams with a scale/bias from 190,
+    // optimized (quantized) keyframes from 192 and the animation end time from 193. Animations
+    // before 192, and every fourth one after, keep their keys in plain keyframe sequences; every fifth
+    // has a constant scale, an empty quantization range.
+    // Colours alternate between V4_8 and V4_5, every other skinned primitive has V4_16 weights and
+    // V4_5 bone indices; skinned primitives index the bones of their mesh through a used-bone table.
+    [[nodiscard]] std::vector<u8> generate_hgr(const synthetic_hgr& params);
+
+    [[nodiscard]] bool write_hgr(const std::filesystem::path& path, const synthetic_hgr& params);
+}
@@ -0,0 +1,277 @@
+// ka3d-convert: converts .hgr files without the app, for build servers.
+//
+//   ka3d-convert [options] <file or directory>...
+//
+// Directories are walked recursively. Every file that matches an --include glob (default *.hgr) and no
+// --exclude glob is converted, -j of them at a time. Output mirrors the input tree under -o.
+// One JSON object per file goes to the summary (stdout by default):
+//   {"file":"levels/a.hgr","status":"ok","bytes_in":1234,"bytes_out":5678,"seconds":0.0123}
+// --stats adds "stats":{...} with the per-stage timers and counters of the conversion, see GetStats.
+// --trace writes a timeline of the whole run for chrome://tracing or ui.perfetto.dev, see EndTrace.
+// Builds without the FBX exporter only parse: a file that parses gets "status":"parsed" instead of "ok"
+// and nothing is written.
+// The exit code is 0 if every file converted, 1 if any failed and 2 for bad arguments.
+#include "../HGR/HGR.h"
+#include "../Common/Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace tools;
+namespace fs = std::filesystem;
+
+namespace {
+    // What a file that went through StoreData gets, and what the run's last line says was done to it
+    constexpr const char* DONE_STATUS{ TOOLS_WITH_FBX ? "ok" : "parsed" };
+    constexpr const char* DONE_VERB{ TOOLS_WITH_FBX ? "converted" : "parsed, none written (built without the FBX exporter)" };
+
+    struct options {
+        std::vector<std::string>    inputs{};
+        std::vector<std::string>    includes{};
+        std::vector<std::string>    excludes{};
+        std::string                 outDir{}; // empty: next to each input
+        std::string                 texDir{}; // empty: the input's own directory
+        std::string                 summary{}; // empty: stdout
+        std::string                 trace{}; // empty: no timeline
+        u32                         jobs{ 0 }; // 0 = one per hardware thread
+        bool                        stats{ false };
+    };
+
+    struct job {
+        fs::path                    path{};
+        std::string                 relative{}; // to the root it was found under, '/' separated
+        fs::path                    outDir{};
+        fs::path                    texDir{};
+    };
+
+    struct result {
+        bool                        ok{ false };
+        u64                         bytesIn{ 0 };
+        u64                         bytesOut{ 0 };
+        f64                         seconds{ 0.0 };
+        std::string                 stats{}; // JSON object, only with --stats
+    };
+
+    void usage() {
+        std::fprintf(stderr,
+            "usage: ka3d-convert [options] <file or directory>...\n"
+            "  -o <dir>             output directory, the input tree is mirrored below it (default: next to each file)\n"
+            "  -t <dir>             texture directory (default: the directory of each file)\n"
+            "  -j <n>               parallel jobs, 0 = one per hardware thread (default 0)\n"
+            "  --include <glob>     convert only matching files, may repeat (default *.hgr)\n"
+            "  --exclude <glob>     skip matching files, may repeat\n"
+            "  --summary <file>     write the per-file summary there instead of stdout\n"
+            "  --stats              add per-stage timings and counters to the summary\n"
+            "  --trace <file>       write a Chrome trace_event timeline of the run there\n"
+            "Globs without a '/' match the file name, others the path below the walked directory.\n"
+            "'*' and '?' stop at '/', '**' doesn't. Matching ignores case.\n");
+    }
+
+    char lower(char c) { return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c; }
+
+    bool glob_match(std::string_view p, std::string_view t) {
+        while (!p.empty()) {
+            if (p[0] == '*') {
+                const bool deep = p.size() > 1 && p[1] == '*';
+                p.remove_prefix(deep ? 2 : 1);
+                if (deep && !p.empty() && p[0] == '/' && glob_match(p.substr(1), t)) return true; // "**/" may be no directory at all
+
+                for (size_t i{ 0 };i <= t.size();++i) {
+                    if (glob_match(p, t.substr(i))) return true;
+                    if (i < t.size() && t[i] == '/' && !deep) return false;
+                }
+                return false;
+            }
+            if (t.empty()) return false;
+            if (p[0] == '?' ? t[0] == '/' : lower(p[0]) != lower(t[0])) return false;
+            p.remove_prefix(1);
+            t.remove_prefix(1);
+        }
+        return t.empty();
+    }
+
+    bool matches_any(const std::vector<std::string>& globs, const std::string& relative) {
+        const std::string_view name = std::string_view(relative).substr(relative.find_last_of('/') + 1); // npos + 1 == 0
+        for (const std::string& glob : globs) {
+            const bool path = glob.find('/') != std::string::npos;
+            if (glob_match(glob, path ? std::string_view(relative) : name)) return true;
+        }
+        return false;
+    }
+
+    bool parse_args(int argc, char** argv, options& opt) {
+        for (int i{ 1 };i < argc;++i) {
+            const std::string_view arg = argv[i];
+            auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+            const char* v{ nullptr };
+            if (arg == "-h" || arg == "--help") return false;
+            else if (arg == "-o") { if (!(v = value())) return false; opt.outDir = v; }
+            else if (arg == "-t") { if (!(v = value())) return false; opt.texDir = v; }
+            else if (arg == "-j") {
+                if (!(v = value())) return false;
+                char* end{ nullptr };
+                const unsigned long n = std::strtoul(v, &end, 10);
+                if (end == v || *end) return false;
+                opt.jobs = u32(n);
+            }
+            else if (arg == "--include") { if (!(v = value())) return false; opt.includes.emplace_back(v); }
+            else if (arg == "--exclude") { if (!(v = value())) return false; opt.excludes.emplace_back(v); }
+            else if (arg == "--summary") { if (!(v = value())) return false; opt.summary = v; }
+            else if (arg == "--stats") opt.stats = true;
+            else if (arg == "--trace") { if (!(v = value())) return false; opt.trace = v; }
+            else if (arg.size() > 1 && arg[0] == '-') return false;
+            else opt.inputs.emplace_back(arg);
+        }
+        if (opt.includes.empty()) opt.includes.emplace_back("*.hgr");
+        return !opt.inputs.empty();
+    }
+
+    void add_job(std::vector<job>& jobs, const options& opt, const fs::path& path, const fs::path& relative) {
+        job j{};
+        j.path = path;
+        j.relative = relative.generic_string();
+        if (!matches_any(opt.includes, j.relative) || matches_any(opt.excludes, j.relative)) return;
+
+        j.outDir = opt.outDir.empty() ? path.parent_path() : fs::path(opt.outDir) / relative.parent_path();
+        j.texDir = opt.texDir.empty() ? path.parent_path() : fs::path(opt.texDir);
+        jobs.emplace_back(std::move(j));
+    }
+
+    // Returns false if an input doesn't exist, everything that does is still collected
+    bool collect(const options& opt, std::vector<job>& jobs) {
+        bool ok{ true };
+        for (const std::string& input : opt.inputs) {
+            std::error_code ec{};
+            const fs::path root{ input };
+
+            if (fs::is_regular_file(root, ec)) {
+                add_job(jobs, opt, root, root.filename());
+                continue;
+            }
+            if (!fs::is_directory(root, ec)) {
+                std::fprintf(stderr, "ka3d-convert: %s: no such file or directory\n", input.c_str());
+                ok = false;
+                continue;
+            }
+
+            const size_t first = jobs.size();
+            for (fs::recursive_directory_iterator it{ root, fs::directory_options::skip_permission_denied, ec }, end{};
+                 !ec && it != end; it.increment(ec)) {
+                std::error_code entry{}; // a broken link mustn't end the walk
+                if (it->is_regular_file(entry)) add_job(jobs, opt, it->path(), it->path().lexically_relative(root));
+            }
+            if (ec) std::fprintf(stderr, "ka3d-convert: %s: %s\n", input.c_str(), ec.message().c_str());
+
+            // Directory order is up to the file system, keep the summary stable between runs
+            std::sort(jobs.begin() + first, jobs.end(), [](const job& a, const job& b) { return a.relative < b.relative; });
+        }
+        return ok;
+    }
+
+    // The exporter names its output after the input's stem, see CreateFBX
+    u64 output_size(const job& j) {
+        std::error_code ec{};
+        const fs::path stem = j.outDir / j.path.stem();
+        for (const fs::path& out : { fs::path(stem).concat(".fbx"), stem }) {
+            const u64 size = fs::file_size(out, ec);
+            if (!ec) return size;
+        }
+        return 0;
+    }
+
+    result convert(const job& j) {
+        const auto start = std::chrono::steady_clock::now();
+        result r{};
+
+        std::error_code ec{};
+        r.bytesIn = fs::file_size(j.path, ec);
+        fs::create_directories(j.outDir, ec);
+
+        const std::string path = j.path.string();
+        try {
+            r.ok = hgr::StoreData(path.c_str(), j.texDir.string().c_str(), j.outDir.string().c_str());
+        }
+        catch (const std::exception&) { // e.g. unimplemented node types in the exporter
+            r.ok = false;
+        }
+        if (const u32 size = hgr::GetStats(path.c_str(), nullptr, 0)) { // 0 unless --stats
+            r.stats.resize(size);
+            r.stats.resize(hgr::GetStats(path.c_str(), r.stats.data(), size) - 1);
+        }
+        if (r.ok && TOOLS_WITH_FBX) r.bytesOut = output_size(j);
+
+        r.seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        return r;
+    }
+
+    void write_json_string(FILE* out, std::string_view s) {
+        std::fputc('"', out);
+        for (const char c : s) {
+            if (c == '"' || c == '\\') std::fprintf(out, "\\%c", c);
+            else if (u8(c) < 0x20) std::fprintf(out, "\\u%04x", unsigned(u8(c)));
+            else std::fputc(c, out);
+        }
+        std::fputc('"', out);
+    }
+}
+
+int main(int argc, char** argv) {
+    options opt{};
+    if (!parse_args(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<job> jobs;
+    bool ok = collect(opt, jobs);
+
+    hgr::EnableStats(opt.stats);
+    if (!opt.trace.empty()) hgr::BeginTrace();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<result> results(jobs.size());
+    parallel_for(u32(jobs.size()), opt.jobs, [&](u32 i) { results[i] = convert(jobs[i]); });
+    const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+    if (!opt.trace.empty() && !hgr::EndTrace(opt.trace.c_str())) {
+        std::fprintf(stderr, "ka3d-convert: can't write %s\n", opt.trace.c_str());
+        ok = false;
+    }
+
+    FILE* out = opt.summary.empty() ? stdout : std::fopen(opt.summary.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "ka3d-convert: can't write %s\n", opt.summary.c_str());
+        return 2;
+    }
+
+    u32 converted{ 0 };
+    u64 bytesIn{ 0 };
+    for (size_t i{ 0 };i < jobs.size();++i) {
+        const result& r = results[i];
+        converted += r.ok;
+        bytesIn += r.bytesIn;
+
+        std::fputs("{\"file\":", out);
+        write_json_string(out, jobs[i].path.generic_string());
+        std::fprintf(out, ",\"status\":\"%s\",\"bytes_in\":%llu,\"bytes_out\":%llu,\"seconds\":%.6f",
+                     r.ok ? DONE_STATUS : "failed", (unsigned long long)r.bytesIn, (unsigned long long)r.bytesOut, r.seconds);
+        if (!r.stats.empty()) std::fprintf(out, ",\"stats\":%s", r.stats.c_str());
+        std::fputs("}\n", out);
+    }
+    if (out != stdout) std::fclose(out);
+
+    std::fprintf(stderr, "ka3d-convert: %u/%zu files %s, %.1f MB in %.3f s on %u threads\n",
+                 converted, jobs.size(), DONE_VERB, bytesIn / 1e6, seconds, worker_count(opt.jobs, u32(std::max<size_t>(jobs.size(), 1))));
+
+    ok = ok && converted == jobs.size();
+    return ok ? 0 : 1;
+}
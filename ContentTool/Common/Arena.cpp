@@ -0,0 +1,78 @@
+#include "Arena.h"
+#include "Stats.h"
+#include <cstdlib>
+
+namespace tools {
+
+	namespace {
+		u8* align_up(u8* p, size_t alignment) {
+			const uintptr_t v = reinterpret_cast<uintptr_t>(p);
+			return reinterpret_cast<u8*>((v + alignment - 1) & ~(uintptr_t(alignment) - 1));
+		}
+	} // Anonymous Namespace
+
+	void* Arena::allocate(size_t bytes, size_t alignment) {
+		_bytesAllocated += bytes;
+		stats::add(stats::COUNTER_ARENA_ALLOCATIONS, 1);
+		stats::add(stats::COUNTER_ARENA_BYTES, bytes);
+
+		if (_at) {
+			u8* p = align_up(_at, alignment);
+			if (p + bytes <= _end) {
+				_at = p + bytes;
+				return p;
+			}
+		}
+
+		// Oversized requests get a block of their own, the current block keeps serving small ones
+		if (bytes + alignment > _blockSize) {
+			return align_up(new_block(bytes + alignment), alignment);
+		}
+
+		u8* start = new_block(_blockSize);
+		_end = start + _blockSize;
+
+		u8* p = align_up(start, alignment);
+		_at = p + bytes;
+		return p;
+	}
+
+	u8* Arena::new_block(size_t size) {
+		constexpr size_t header{ (sizeof(block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1) };
+
+		void* memory = std::malloc(header + size);
+		if (!memory) throw std::bad_alloc{};
+		stats::add(stats::COUNTER_HEAP_BLOCKS, 1);
+
+		block* b = static_cast<block*>(memory);
+		b->next = _blocks;
+		b->size = size;
+		_blocks = b;
+		return static_cast<u8*>(memory) + header;
+	}
+
+	void Arena::add_finalizer(void* object, size_t count, void (*destroy)(void*, size_t)) {
+		finalizer* f = static_cast<finalizer*>(allocate(sizeof(finalizer), alignof(finalizer)));
+		f->destroy = destroy;
+		f->object = object;
+		f->count = count;
+		f->next = _finalizers;
+		_finalizers = f;
+	}
+
+	void Arena::release() {
+		for (finalizer* f = _finalizers; f; f = f->next) {
+			f->destroy(f->object, f->count);
+		}
+		_finalizers = nullptr;
+
+		while (_blocks) {
+			block* next = _blocks->next;
+			std::free(_blocks);
+			_blocks = next;
+		}
+		_at = nullptr;
+		_end = nullptr;
+		_bytesAllocated = 0;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "PrimitiveTypes.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace tools {
+
+	// Monotonic allocator: memory is carved out of large blocks and only given back all at once, by
+	// release() or the destructor. Objects that need a destructor get it run at that point too, newest first.
+	// Nothing allocated from an arena may be deleted on its own.
+	class Arena {
+	public:
+		explicit Arena(size_t blockSize = 64 * 1024) : _blockSize{ blockSize } {}
+		~Arena() { release(); }
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		// Value-initialized like new T[count]{}. Never returns null, even for count == 0.
+		template<typename T>
+		[[nodiscard]] T* create_array(size_t count) {
+			T* array = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+			for (size_t i{ 0 };i < count;++i) ::new (static_cast<void*>(array + i)) T{};
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				add_finalizer(array, count, [](void* object, size_t n) {
+					for (size_t i{ 0 };i < n;++i) static_cast<T*>(object)[i].~T();
+				});
+			}
+			return array;
+		}
+
+		template<typename T, typename... Args>
+		[[nodiscard]] T* create(Args&&... args) {
+			T* object = ::new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				add_finalizer(object, 1, [](void* o, size_t) { static_cast<T*>(o)->~T(); });
+			}
+			return object;
+		}
+
+		[[nodiscard]] void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+		// Runs the pending destructors and frees every block
+		void release();
+
+		[[nodiscard]] size_t bytes_allocated() const { return _bytesAllocated; }
+
+	private:
+		struct block {
+			block*			next;
+			size_t			size; // usable bytes after the header
+		};
+
+		struct finalizer {
+			void			(*destroy)(void*, size_t);
+			void*			object;
+			size_t			count;
+			finalizer*		next;
+		};
+
+		u8* new_block(size_t size);
+		void add_finalizer(void* object, size_t count, void (*destroy)(void*, size_t));
+
+		block*				_blocks{ nullptr };
+		u8*					_at{ nullptr }; // next free byte in the current block
+		u8*					_end{ nullptr };
+		finalizer*			_finalizers{ nullptr };
+		size_t				_blockSize;
+		size_t				_bytesAllocated{ 0 };
+	};
+}
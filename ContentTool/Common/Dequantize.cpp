@@ -0,0 +1,361 @@
+#include "Dequantize.h"
+#include <cassert>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TOOLS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TOOLS_TARGET_AVX2
+#else
+#define TOOLS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace tools {
+
+	namespace {
+		// Vector kernels work on the stream as one flat run of count * dim components. A block of
+		// 'dim' vectors (dim * lanes components) always starts on an element boundary, so the bias of
+		// every lane in the block is known up front; pattern[] holds it, repeated.
+		template<u32 Lanes>
+		struct bias_pattern {
+			f32 values[4 * Lanes];
+
+			bias_pattern(u32 dim, const f32* bias) {
+				for (u32 i{ 0 };i < dim * Lanes;++i) values[i] = bias[i % dim];
+			}
+		};
+
+		template<typename T>
+		void scalar_tail(const s16* src, u32 first, u32 total, u32 dim, f32 scale, const f32* bias, T* out) {
+			for (u32 i{ first };i < total;++i) {
+				out[i] = T(f32(src[i]) * scale + bias[i % dim]);
+			}
+		}
+
+		// Keys [first, count) one component at a time
+		void keys_tail(const u8* src, u32 first, u32 count, u32 dim, const f32* min, const f32* delta, f32* out) {
+			for (u32 i{ first };i < count;++i) {
+				for (u32 k{ 0 };k < 4;++k) {
+					f32 x{ 0.f };
+					if (k < dim) {
+						u16 xi;
+						memcpy(&xi, src + (size_t(i) * dim + k) * sizeof(u16), sizeof(u16));
+						x = f32(xi) * (1.f / 65535.f);
+						x *= delta[k];
+						x += min[k];
+					}
+					out[size_t(i) * 4 + k] = x;
+				}
+			}
+		}
+
+		void u8_tail(const u8* src, u32 first, u32 total, u32 dim, f32 scale, const f32* bias, f32* out) {
+			for (u32 i{ first };i < total;++i) {
+				out[i] = f32(src[i]) * (1.f / 255.f) * scale + bias[i % dim];
+			}
+		}
+
+		void u5551_tail(const u8* src, u32 first, u32 count, f32 scale, const f32* bias, f32* out) {
+			for (u32 i{ first };i < count;++i) {
+				u16 v;
+				memcpy(&v, src + size_t(i) * sizeof(u16), sizeof(u16));
+				for (u32 k{ 0 };k < 3;++k) {
+					out[size_t(i) * 4 + k] = f32((v >> (5 * k)) & 0x1f) * (1.f / 31.f) * scale + bias[k];
+				}
+				out[size_t(i) * 4 + 3] = f32(v >> 15) * scale + bias[3];
+			}
+		}
+
+#ifdef TOOLS_X86
+		// 4 components -> 4 floats
+		inline __m128 load4_sse2(const s16* src) {
+			__m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+			v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // sign extend
+			return _mm_cvtepi32_ps(v);
+		}
+
+		template<typename T>
+		void dequantize_sse2(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, T* out) {
+			const u32 total = count * dim;
+			const u32 block = dim * 4;
+			const bias_pattern<4> pattern{ dim, bias };
+			const __m128 s = _mm_set1_ps(scale);
+
+			u32 i{ 0 };
+			for (;i + block <= total;i += block) {
+				for (u32 j{ 0 };j < dim;++j) {
+					const u32 at = i + j * 4;
+					__m128 v = _mm_add_ps(_mm_mul_ps(load4_sse2(src + at), s), _mm_loadu_ps(pattern.values + j * 4));
+					if constexpr (sizeof(T) == sizeof(f32)) {
+						_mm_storeu_ps(reinterpret_cast<f32*>(out + at), v);
+					}
+					else {
+						_mm_storeu_pd(reinterpret_cast<f64*>(out + at), _mm_cvtps_pd(v));
+						_mm_storeu_pd(reinterpret_cast<f64*>(out + at + 2), _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+					}
+				}
+			}
+			scalar_tail(src, i, total, dim, scale, bias, out);
+		}
+
+		template<typename T>
+		TOOLS_TARGET_AVX2
+		void dequantize_avx2(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, T* out) {
+			const u32 total = count * dim;
+			const u32 block = dim * 8;
+			const bias_pattern<8> pattern{ dim, bias };
+			const __m256 s = _mm256_set1_ps(scale);
+
+			u32 i{ 0 };
+			for (;i + block <= total;i += block) {
+				for (u32 j{ 0 };j < dim;++j) {
+					const u32 at = i + j * 8;
+					__m256i q = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + at)));
+					// mul + add rather than fma, so the results match the scalar path bit for bit
+					__m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(q), s), _mm256_loadu_ps(pattern.values + j * 8));
+					if constexpr (sizeof(T) == sizeof(f32)) {
+						_mm256_storeu_ps(reinterpret_cast<f32*>(out + at), v);
+					}
+					else {
+						_mm256_storeu_pd(reinterpret_cast<f64*>(out + at), _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+						_mm256_storeu_pd(reinterpret_cast<f64*>(out + at + 4), _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+					}
+				}
+			}
+			scalar_tail(src, i, total, dim, scale, bias, out);
+		}
+
+		// One key per vector. Lane 3 of min/delta is 0 for 3-component keys, which zeroes w even
+		// though the 64-bit load picks up the next key's first component.
+		void keys_sse2(const u8* src, u32 count, u32 dim, const f32* min, const f32* delta, f32* out) {
+			const __m128 inv = _mm_set1_ps(1.f / 65535.f);
+			const __m128 d = _mm_loadu_ps(delta);
+			const __m128 m = _mm_loadu_ps(min);
+			const __m128i zero = _mm_setzero_si128();
+
+			const u32 last = dim == 4 ? count : (count > 0 ? count - 1 : 0); // the load must not run off the end
+			u32 i{ 0 };
+			for (;i < last;++i) {
+				__m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + size_t(i) * dim * sizeof(u16)));
+				__m128 x = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero));
+				x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, inv), d), m);
+				_mm_storeu_ps(out + size_t(i) * 4, x);
+			}
+			keys_tail(src, i, count, dim, min, delta, out);
+		}
+
+		// Two keys per vector
+		TOOLS_TARGET_AVX2
+		void keys_avx2(const u8* src, u32 count, u32 dim, const f32* min, const f32* delta, f32* out) {
+			const __m256 inv = _mm256_set1_ps(1.f / 65535.f);
+			const __m256 d = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(delta));
+			const __m256 m = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(min));
+			const size_t stride = size_t(dim) * sizeof(u16);
+
+			const u32 pairs = dim == 4 ? count / 2 : (count > 0 ? (count - 1) / 2 : 0);
+			u32 i{ 0 };
+			for (;i < pairs * 2;i += 2) {
+				const u8* at = src + i * stride;
+				__m128i q = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(at)),
+											   _mm_loadl_epi64(reinterpret_cast<const __m128i*>(at + stride)));
+				__m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(q));
+				x = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(x, inv), d), m);
+				_mm256_storeu_ps(out + size_t(i) * 4, x);
+			}
+			keys_tail(src, i, count, dim, min, delta, out);
+		}
+
+		void u8_sse2(const u8* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out) {
+			const u32 total = count * dim;
+			const u32 block = dim * 4;
+			const bias_pattern<4> pattern{ dim, bias };
+			const __m128 inv = _mm_set1_ps(1.f / 255.f);
+			const __m128 s = _mm_set1_ps(scale);
+			const __m128i zero = _mm_setzero_si128();
+
+			u32 i{ 0 };
+			for (;i + block <= total;i += block) {
+				for (u32 j{ 0 };j < dim;++j) {
+					const u32 at = i + j * 4;
+					s32 four;
+					memcpy(&four, src + at, sizeof(four));
+					__m128i q = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(four), zero), zero);
+					__m128 v = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(q), inv), s);
+					_mm_storeu_ps(out + at, _mm_add_ps(v, _mm_loadu_ps(pattern.values + j * 4)));
+				}
+			}
+			u8_tail(src, i, total, dim, scale, bias, out);
+		}
+
+		// One element per vector. The masks keep each field in place, multiplying by a power of two
+		// brings it down exactly, so the result is the same as shifting first.
+		void u5551_sse2(const u8* src, u32 count, f32 scale, const f32* bias, f32* out) {
+			const __m128i mask = _mm_setr_epi32(0x1f, 0x1f << 5, 0x1f << 10, 1 << 15);
+			const __m128 down = _mm_setr_ps(1.f, 1.f / 32.f, 1.f / 1024.f, 1.f / 32768.f);
+			const __m128 norm = _mm_setr_ps(1.f / 31.f, 1.f / 31.f, 1.f / 31.f, 1.f);
+			const __m128 s = _mm_set1_ps(scale);
+			const __m128 b = _mm_loadu_ps(bias);
+
+			for (u32 i{ 0 };i < count;++i) {
+				u16 v;
+				memcpy(&v, src + size_t(i) * sizeof(u16), sizeof(u16));
+				__m128 x = _mm_cvtepi32_ps(_mm_and_si128(_mm_set1_epi32(v), mask));
+				x = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, down), norm), s);
+				_mm_storeu_ps(out + size_t(i) * 4, _mm_add_ps(x, b));
+			}
+		}
+
+		TOOLS_TARGET_AVX2
+		void u8_avx2(const u8* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out) {
+			const u32 total = count * dim;
+			const u32 block = dim * 8;
+			const bias_pattern<8> pattern{ dim, bias };
+			const __m256 inv = _mm256_set1_ps(1.f / 255.f);
+			const __m256 s = _mm256_set1_ps(scale);
+
+			u32 i{ 0 };
+			for (;i + block <= total;i += block) {
+				for (u32 j{ 0 };j < dim;++j) {
+					const u32 at = i + j * 8;
+					__m256i q = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + at)));
+					__m256 v = _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(q), inv), s);
+					_mm256_storeu_ps(out + at, _mm256_add_ps(v, _mm256_loadu_ps(pattern.values + j * 8)));
+				}
+			}
+			u8_tail(src, i, total, dim, scale, bias, out);
+		}
+
+		// Two elements per vector, with a variable shift per lane
+		TOOLS_TARGET_AVX2
+		void u5551_avx2(const u8* src, u32 count, f32 scale, const f32* bias, f32* out) {
+			const __m256i shift = _mm256_setr_epi32(0, 5, 10, 15, 0, 5, 10, 15);
+			const __m256i mask = _mm256_setr_epi32(0x1f, 0x1f, 0x1f, 1, 0x1f, 0x1f, 0x1f, 1);
+			const __m256 norm = _mm256_setr_ps(1.f / 31.f, 1.f / 31.f, 1.f / 31.f, 1.f, 1.f / 31.f, 1.f / 31.f, 1.f / 31.f, 1.f);
+			const __m256 s = _mm256_set1_ps(scale);
+			const __m256 b = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(bias));
+
+			u32 i{ 0 };
+			for (;i + 2 <= count;i += 2) {
+				u16 v[2];
+				memcpy(v, src + size_t(i) * sizeof(u16), sizeof(v));
+				__m256i q = _mm256_setr_epi32(v[0], v[0], v[0], v[0], v[1], v[1], v[1], v[1]);
+				q = _mm256_and_si256(_mm256_srlv_epi32(q, shift), mask);
+				__m256 x = _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(q), norm), s);
+				_mm256_storeu_ps(out + size_t(i) * 4, _mm256_add_ps(x, b));
+			}
+			u5551_tail(src, i, count, scale, bias, out);
+		}
+
+		bool cpu_has_avx2() {
+#ifdef _MSC_VER
+			int info[4]{};
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false; // OS saves the ymm registers
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif // TOOLS_X86
+
+		SimdLevel detect_simd_level() {
+#ifdef TOOLS_X86
+			return cpu_has_avx2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+			return SimdLevel::Scalar;
+#endif
+		}
+
+		template<typename T>
+		void dequantize(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, T* out) {
+			assert(dim >= 1 && dim <= 4);
+			switch (simd_level())
+			{
+#ifdef TOOLS_X86
+			case SimdLevel::AVX2:	dequantize_avx2(src, count, dim, scale, bias, out); return;
+			case SimdLevel::SSE2:	dequantize_sse2(src, count, dim, scale, bias, out); return;
+#endif
+			default:				scalar_tail(src, 0, count * dim, dim, scale, bias, out); return;
+			}
+		}
+	} // Anonymous Namespace
+
+	void dequantize_u8_unorm(const u8* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out) {
+		assert(dim >= 1 && dim <= 4);
+		switch (simd_level())
+		{
+#ifdef TOOLS_X86
+		case SimdLevel::AVX2:	u8_avx2(src, count, dim, scale, bias, out); return;
+		case SimdLevel::SSE2:	u8_sse2(src, count, dim, scale, bias, out); return;
+#endif
+		default:				u8_tail(src, 0, count * dim, dim, scale, bias, out); return;
+		}
+	}
+
+	void unpack_u16_5551(const u8* src, u32 count, f32 scale, const f32* bias, f32* out) {
+		switch (simd_level())
+		{
+#ifdef TOOLS_X86
+		case SimdLevel::AVX2:	u5551_avx2(src, count, scale, bias, out); return;
+		case SimdLevel::SSE2:	u5551_sse2(src, count, scale, bias, out); return;
+#endif
+		default:				u5551_tail(src, 0, count, scale, bias, out); return;
+		}
+	}
+
+	void dequantize_u16_keys(const u8* src, u32 count, u32 dim, const f32* min, const f32* max, f32* out) {
+		assert(dim == 3 || dim == 4);
+		f32 lo[4]{}, delta[4]{};
+		for (u32 k{ 0 };k < dim;++k) {
+			lo[k] = min[k];
+			delta[k] = max[k] - min[k];
+		}
+
+		switch (simd_level())
+		{
+#ifdef TOOLS_X86
+		case SimdLevel::AVX2:	keys_avx2(src, count, dim, lo, delta, out); return;
+		case SimdLevel::SSE2:	keys_sse2(src, count, dim, lo, delta, out); return;
+#endif
+		default:				keys_tail(src, 0, count, dim, lo, delta, out); return;
+		}
+	}
+
+	void dequantize_u16_keys_scalar(const u8* src, u32 count, u32 dim, const f32* min, const f32* max, f32* out) {
+		f32 lo[4]{}, delta[4]{};
+		for (u32 k{ 0 };k < dim;++k) {
+			lo[k] = min[k];
+			delta[k] = max[k] - min[k];
+		}
+		keys_tail(src, 0, count, dim, lo, delta, out);
+	}
+
+	SimdLevel simd_level() {
+		static const SimdLevel level = detect_simd_level();
+		return level;
+	}
+
+	void dequantize_s16(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out) {
+		dequantize(src, count, dim, scale, bias, out);
+	}
+
+	void dequantize_s16(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f64* out) {
+		dequantize(src, count, dim, scale, bias, out);
+	}
+
+	void dequantize_s16_scalar(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out) {
+		scalar_tail(src, 0, count * dim, dim, scale, bias, out);
+	}
+
+	void dequantize_s16_scalar(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f64* out) {
+		scalar_tail(src, 0, count * dim, dim, scale, bias, out);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "PrimitiveTypes.h"
+
+namespace tools {
+
+	// Bulk dequantization of 16-bit vertex streams, usable by any exporter.
+	//
+	// 'src' holds 'count' elements of 'dim' (1..4) signed 16-bit components, packed back to back.
+	// Every component becomes src * scale + bias[k], computed in single precision like the scalar
+	// code always did; the f64 variant only widens the result. 'src' needs 2-byte alignment, nothing
+	// else does. The widest kernel the CPU supports (AVX2, SSE2, or plain C++) is picked on first use.
+
+	void dequantize_s16(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out);
+	void dequantize_s16(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f64* out);
+
+	// The plain C++ versions, always available. Handy as a reference.
+	void dequantize_s16_scalar(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out);
+	void dequantize_s16_scalar(const s16* src, u32 count, u32 dim, f32 scale, const f32* bias, f64* out);
+
+	// Unsigned normalized 8-bit streams (colors, normals, bone weights): 'count' elements of 'dim' (1..4)
+	// bytes, each component becomes (src / 255) * scale + bias[k].
+	void dequantize_u8_unorm(const u8* src, u32 count, u32 dim, f32 scale, const f32* bias, f32* out);
+
+	// DF_V4_5: one little-endian u16 per element, x/y/z in 5 bits each from the low end, w in the top bit.
+	// x/y/z become (bits / 31) * scale + bias[k], w becomes bit * scale + bias[3]. No alignment needed.
+	void unpack_u16_5551(const u8* src, u32 count, f32 scale, const f32* bias, f32* out);
+
+	// Animation keys quantized to the [min, max] box of their track. 'src' holds 'count' keys of 'dim'
+	// (3 or 4) unsigned 16-bit components, with no alignment requirement. Every key is written as 4
+	// floats, min[k] + (src / 65535) * (max[k] - min[k]), with w = 0 for 3-component keys. The
+	// arithmetic is the same as the per-component reference, so results match it bit for bit.
+
+	void dequantize_u16_keys(const u8* src, u32 count, u32 dim, const f32* min, const f32* max, f32* out);
+	void dequantize_u16_keys_scalar(const u8* src, u32 count, u32 dim, const f32* min, const f32* max, f32* out);
+
+	enum class SimdLevel : u8 {
+		Scalar,
+		SSE2,
+		AVX2,
+	};
+
+	// What the kernels above run with on this machine
+	[[nodiscard]] SimdLevel simd_level();
+}
@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tools {
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+			_data = other._data; other._data = nullptr;
+			_size = other._size; other._size = 0;
+#ifdef _WIN32
+			_file = other._file; other._file = nullptr;
+			_mapping = other._mapping; other._mapping = nullptr;
+#endif
+		}
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::filesystem::path& path) {
+		close();
+
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+								  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { // an empty file can't be mapped
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) {
+			CloseHandle(file);
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		_file = file;
+		_mapping = mapping;
+		_data = static_cast<const u8*>(view);
+		_size = static_cast<u64>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file) CloseHandle(_file);
+		_data = nullptr; _mapping = nullptr; _file = nullptr;
+		_size = 0;
+	}
+#else
+	bool MappedFile::open(const std::filesystem::path& path) {
+		close();
+
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return false;
+
+		struct stat st {};
+		if (fstat(fd, &st) != 0 || st.st_size == 0) { // an empty file can't be mapped
+			::close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping keeps its own reference to the file
+		if (view == MAP_FAILED) return false;
+
+		madvise(view, static_cast<size_t>(st.st_size), MADV_WILLNEED); // the whole file gets parsed anyway
+
+		_data = static_cast<const u8*>(view);
+		_size = static_cast<u64>(st.st_size);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (_data) munmap(const_cast<u8*>(_data), static_cast<size_t>(_size));
+		_data = nullptr;
+		_size = 0;
+	}
+#endif
+}
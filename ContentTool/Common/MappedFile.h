@@ -0,0 +1,36 @@
+#pragma once
+#include "PrimitiveTypes.h"
+#include <filesystem>
+
+namespace tools {
+
+	// Read-only memory mapping of a whole file. The view stays valid for as long as the object lives,
+	// so anything pointing into data() must not outlive it.
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile() { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		[[nodiscard]]
+		bool open(const std::filesystem::path& path);
+		void close();
+
+		[[nodiscard]] const u8* data() const { return _data; }
+		[[nodiscard]] u64 size() const { return _size; }
+		[[nodiscard]] bool is_open() const { return _data != nullptr; }
+
+	private:
+		const u8*			_data{ nullptr };
+		u64					_size{ 0 };
+#ifdef _WIN32
+		void*				_file{ nullptr }; // HANDLE
+		void*				_mapping{ nullptr }; // HANDLE
+#endif
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "PrimitiveTypes.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace tools {
+
+	// Number of workers to use when the caller asks for 'requested' (0 = one per hardware thread).
+	[[nodiscard]]
+	inline u32 worker_count(u32 requested, u32 jobs) {
+		u32 threads = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+		return std::max(1u, std::min(threads, jobs));
+	}
+
+	// Runs job(i) for every i in [0, count) on a small pool of worker threads. Workers pull the next
+	// index from a shared counter, so one big file doesn't hold up the small ones queued behind it.
+	// The calling thread works too and the call returns once every job has finished.
+	// job must not throw.
+	template<typename Job>
+	void parallel_for(u32 count, u32 threads, Job&& job) {
+		if (!count) return;
+		threads = worker_count(threads, count);
+
+		std::atomic<u32> next{ 0 };
+		auto worker = [&]() {
+			for (u32 i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed)) {
+				job(i);
+			}
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (u32 t{ 1 };t < threads;++t) pool.emplace_back(worker);
+		worker();
+		for (auto& t : pool) t.join();
+	}
+}
@@ -16,9 +16,10 @@ using s32 = int32_t;
 using s16 = int16_t;
 using s8 = int8_t;
 
-constexpr u64 u64_invalid_id(0xffff'ffff'ffff'ffffui64);
-constexpr u32 u32_invalid_id(0xffff'ffffui32);
-constexpr u16 u16_invalid_id(0xffffui16);
-constexpr u8 u8_invalid_id(0xffui8);
+constexpr u64 u64_invalid_id(0xffff'ffff'ffff'ffffull);
+constexpr u32 u32_invalid_id(0xffff'ffffu);
+constexpr u16 u16_invalid_id(0xffffu);
+constexpr u8 u8_invalid_id(0xffu);
 
-using f32 = float;
\ No newline at end of file
+using f32 = float;
+using f64 = double;
\ No newline at end of file
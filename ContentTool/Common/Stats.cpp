@@ -0,0 +1,112 @@
+#include "Stats.h"
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+namespace tools::stats {
+
+	namespace {
+		constexpr const char* TIMER_NAMES[TIMER_COUNT]{
+			"total", "file_open", "index",
+			"parse.materials", "parse.primitives", "parse.meshes", "parse.cameras", "parse.lights",
+			"parse.dummies", "parse.shapes", "parse.othernodes", "parse.transformanimations", "parse.userproperties",
+			"vertex_decode", "hierarchy",
+			"fbx.scene", "fbx.nodes", "fbx.animation", "fbx.save",
+		};
+
+		constexpr const char* COUNTER_NAMES[COUNTER_COUNT]{
+			"file_bytes",
+			"bytes.materials", "bytes.primitives", "bytes.meshes", "bytes.cameras", "bytes.lights",
+			"bytes.dummies", "bytes.shapes", "bytes.othernodes", "bytes.transformanimations", "bytes.userproperties",
+			"arena_allocations", "arena_bytes", "heap_blocks",
+			"vertices", "indices", "keys",
+			"fbx.nodes", "fbx.meshes", "fbx.materials", "fbx.textures", "fbx.cameras", "fbx.lights", "fbx.curves",
+		};
+
+		std::atomic<bool> gEnabled{ false };
+
+		// Last stats of every file, as JSON. Only touched once per conversion.
+		std::mutex gPublishedMutex;
+		std::map<std::string, std::string> gPublished;
+
+		void append_json_string(std::string& out, const std::string& s) {
+			out += '"';
+			for (const char c : s) {
+				if (c == '"' || c == '\\') { out += '\\'; out += c; }
+				else if (u8(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(u8(c)));
+					out += escaped;
+				}
+				else out += c;
+			}
+			out += '"';
+		}
+	} // Anonymous Namespace
+
+	void set_enabled(bool enabled) { gEnabled.store(enabled, std::memory_order_relaxed); }
+	bool enabled() { return gEnabled.load(std::memory_order_relaxed); }
+
+	std::string to_json(const std::string& path, const file_stats& stats) {
+		std::string out{ "{\"file\":" };
+		append_json_string(out, path);
+
+		char number[64];
+		out += ",\"timers\":{";
+		for (u32 t{ 0 };t < TIMER_COUNT;++t) {
+			std::snprintf(number, sizeof(number), "%s\"%s\":{\"ms\":%.3f,\"calls\":%llu}", t ? "," : "",
+						  TIMER_NAMES[t], stats.seconds[t] * 1e3, (unsigned long long)stats.calls[t]);
+			out += number;
+		}
+		out += "},\"counters\":{";
+		for (u32 c{ 0 };c < COUNTER_COUNT;++c) {
+			std::snprintf(number, sizeof(number), "%s\"%s\":%llu", c ? "," : "", COUNTER_NAMES[c], (unsigned long long)stats.counters[c]);
+			out += number;
+		}
+		out += "}}";
+		return out;
+	}
+
+	std::string published_json(const char* path) {
+		std::lock_guard<std::mutex> lock{ gPublishedMutex };
+		if (path) {
+			auto it = gPublished.find(path);
+			return it != gPublished.end() ? it->second : std::string{};
+		}
+
+		std::string out{ "{\"files\":[" };
+		for (const auto& [file, json] : gPublished) {
+			if (out.back() != '[') out += ',';
+			out += json;
+		}
+		out += "]}";
+		return out;
+	}
+
+	void clear_published() {
+		std::lock_guard<std::mutex> lock{ gPublishedMutex };
+		gPublished.clear();
+	}
+
+#if TOOLS_WITH_STATS
+	file_scope::file_scope(const char* path) {
+		if (!enabled() || !path) return;
+		_path = path;
+		_previous = detail::current;
+		detail::current = &_stats;
+		_start = std::chrono::steady_clock::now();
+	}
+
+	file_scope::~file_scope() {
+		if (!_path) return;
+		_stats.seconds[TIMER_TOTAL] = std::chrono::duration<f64>(std::chrono::steady_clock::now() - _start).count();
+		_stats.calls[TIMER_TOTAL] = 1;
+		detail::current = _previous;
+
+		std::string json = to_json(_path, _stats);
+		std::lock_guard<std::mutex> lock{ gPublishedMutex };
+		gPublished[_path] = std::move(json);
+	}
+#endif
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "PrimitiveTypes.h"
+#include <chrono>
+#include <string>
+
+// Builds without the instrumentation compile every timer and counter down to nothing
+#ifndef TOOLS_WITH_STATS
+#define TOOLS_WITH_STATS 1
+#endif
+
+namespace tools::stats {
+
+	// Timers nest: the primitives section includes the vertex decode, the FBX scene the nodes and animations
+	enum Timer {
+		TIMER_TOTAL,
+		TIMER_FILE_OPEN,
+		TIMER_INDEX, // the bounds-checked pass StoreData makes before decoding
+		TIMER_PARSE_MATERIALS, // one per hgr::Section, in the same order
+		TIMER_PARSE_PRIMITIVES,
+		TIMER_PARSE_MESHES,
+		TIMER_PARSE_CAMERAS,
+		TIMER_PARSE_LIGHTS,
+		TIMER_PARSE_DUMMIES,
+		TIMER_PARSE_SHAPES,
+		TIMER_PARSE_OTHERNODES,
+		TIMER_PARSE_TRANSFORMANIMATIONS,
+		TIMER_PARSE_USERPROPERTIES,
+		TIMER_VERTEX_DECODE, // build_geometry
+		TIMER_HIERARCHY,
+		TIMER_FBX_SCENE,
+		TIMER_FBX_NODES,
+		TIMER_FBX_ANIMATION,
+		TIMER_FBX_SAVE,
+
+		TIMER_COUNT
+	};
+
+	enum Counter {
+		COUNTER_FILE_BYTES,
+		COUNTER_BYTES_MATERIALS, // bytes read per hgr::Section, in the same order
+		COUNTER_BYTES_PRIMITIVES,
+		COUNTER_BYTES_MESHES,
+		COUNTER_BYTES_CAMERAS,
+		COUNTER_BYTES_LIGHTS,
+		COUNTER_BYTES_DUMMIES,
+		COUNTER_BYTES_SHAPES,
+		COUNTER_BYTES_OTHERNODES,
+		COUNTER_BYTES_TRANSFORMANIMATIONS,
+		COUNTER_BYTES_USERPROPERTIES,
+		COUNTER_ARENA_ALLOCATIONS,
+		COUNTER_ARENA_BYTES,
+		COUNTER_HEAP_BLOCKS, // blocks the arenas took from malloc
+		COUNTER_VERTICES,
+		COUNTER_INDICES,
+		COUNTER_KEYS,
+		COUNTER_FBX_NODES,
+		COUNTER_FBX_MESHES,
+		COUNTER_FBX_MATERIALS,
+		COUNTER_FBX_TEXTURES,
+		COUNTER_FBX_CAMERAS,
+		COUNTER_FBX_LIGHTS,
+		COUNTER_FBX_CURVES,
+
+		COUNTER_COUNT
+	};
+
+	struct file_stats {
+		f64			seconds[TIMER_COUNT]{};
+		u64			calls[TIMER_COUNT]{};
+		u64			counters[COUNTER_COUNT]{};
+	};
+
+	// Collection is off until enabled, then StoreData keeps the stats of the last conversion of every file
+	void set_enabled(bool enabled);
+	[[nodiscard]] bool enabled();
+
+	// {"file":..., "timers":{name:{"ms":..,"calls":..}, ...}, "counters":{name:value, ...}}
+	[[nodiscard]] std::string to_json(const std::string& path, const file_stats& stats);
+
+	// JSON of the last conversion of 'path', or {"files":[...]} with every file if path is null.
+	// Empty if there is nothing for path.
+	[[nodiscard]] std::string published_json(const char* path);
+	void clear_published();
+
+	namespace detail {
+		// The stats of the file the calling thread is converting, null when nothing is collected
+		inline thread_local file_stats* current{ nullptr };
+	}
+
+#if TOOLS_WITH_STATS
+	inline void add(Counter counter, u64 amount) {
+		if (file_stats* s = detail::current) s->counters[counter] += amount;
+	}
+
+	class scoped_timer {
+	public:
+		explicit scoped_timer(Timer timer) : _stats{ detail::current }, _timer{ timer } {
+			if (_stats) _start = std::chrono::steady_clock::now();
+		}
+		~scoped_timer() {
+			if (!_stats) return;
+			_stats->seconds[_timer] += std::chrono::duration<f64>(std::chrono::steady_clock::now() - _start).count();
+			++_stats->calls[_timer];
+		}
+
+		scoped_timer(const scoped_timer&) = delete;
+		scoped_timer& operator=(const scoped_timer&) = delete;
+
+	private:
+		file_stats*								_stats;
+		Timer									_timer;
+		std::chrono::steady_clock::time_point	_start{};
+	};
+
+	// Collects everything the calling thread does while it lives as the stats of 'path', then publishes
+	// them. Does nothing while collection is disabled.
+	class file_scope {
+	public:
+		explicit file_scope(const char* path);
+		~file_scope();
+
+		file_scope(const file_scope&) = delete;
+		file_scope& operator=(const file_scope&) = delete;
+
+	private:
+		file_stats								_stats{};
+		file_stats*								_previous{ nullptr };
+		const char*								_path{ nullptr }; // null while disabled
+		std::chrono::steady_clock::time_point	_start{};
+	};
+#else
+	inline void add(Counter, u64) {}
+
+	class scoped_timer {
+	public:
+		explicit scoped_timer(Timer) {}
+	};
+
+	class file_scope {
+	public:
+		explicit file_scope(const char*) {}
+	};
+#endif
+}
@@ -0,0 +1,165 @@
+#include "Trace.h"
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tools::trace {
+
+	namespace {
+		struct event {
+			const char*		name;
+			u32				arg; // interned, 0 = none
+			u64				begin; // ns since start()
+			u64				end;
+		};
+
+		// Written only by its thread. The count is published after the event, so write() can read
+		// everything below it while the thread keeps appending.
+		struct chunk {
+			static constexpr u32	CAPACITY{ 4096 };
+
+			event					events[CAPACITY];
+			std::atomic<u32>		count{ 0 };
+			std::atomic<chunk*>		next{ nullptr };
+		};
+
+		struct thread_buffer {
+			u32								tid{ 0 };
+			std::unique_ptr<chunk>			head{ std::make_unique<chunk>() };
+			chunk*							tail{ head.get() };
+			std::vector<std::unique_ptr<chunk>>	more{}; // owns the chunks after head, only touched by the owning thread
+		};
+
+		std::chrono::steady_clock::time_point gEpoch{ std::chrono::steady_clock::now() };
+
+		// Buffers of the current recording. A start() bumps the generation, threads then register a new buffer.
+		std::mutex gBuffersMutex;
+		std::vector<std::unique_ptr<thread_buffer>> gBuffers;
+		std::atomic<u32> gGeneration{ 1 };
+
+		// Every file name once: a file's zones all intern the same path. The deque keeps the strings
+		// where they are, the ids look them up in place.
+		std::mutex gStringsMutex;
+		std::deque<std::string> gStrings{ std::string{} }; // 0 = none
+		std::unordered_map<std::string_view, u32> gStringIds;
+
+		struct local_buffer {
+			thread_buffer*	buffer{ nullptr };
+			u32				generation{ 0 };
+		};
+		thread_local local_buffer tLocal{};
+
+		thread_buffer& buffer() {
+			const u32 generation = gGeneration.load(std::memory_order_acquire);
+			if (tLocal.generation != generation) {
+				std::lock_guard<std::mutex> lock{ gBuffersMutex };
+				auto b = std::make_unique<thread_buffer>();
+				b->tid = u32(gBuffers.size()) + 1;
+				tLocal.buffer = b.get();
+				tLocal.generation = generation;
+				gBuffers.push_back(std::move(b));
+			}
+			return *tLocal.buffer;
+		}
+
+		void write_json_string(FILE* out, const std::string& s) {
+			std::fputc('"', out);
+			for (const char c : s) {
+				if (c == '"' || c == '\\') std::fprintf(out, "\\%c", c);
+				else if (u8(c) < 0x20) std::fprintf(out, "\\u%04x", unsigned(u8(c)));
+				else std::fputc(c, out);
+			}
+			std::fputc('"', out);
+		}
+	} // Anonymous Namespace
+
+	void start() {
+		{
+			std::lock_guard<std::mutex> lock{ gBuffersMutex };
+			gBuffers.clear();
+			gGeneration.fetch_add(1, std::memory_order_release);
+		}
+		{
+			std::lock_guard<std::mutex> lock{ gStringsMutex };
+			gStringIds.clear();
+			gStrings.resize(1);
+		}
+		gEpoch = std::chrono::steady_clock::now();
+		detail::recording.store(true, std::memory_order_release);
+	}
+
+	void stop() {
+		detail::recording.store(false, std::memory_order_release);
+	}
+
+	bool write(const char* path) {
+		FILE* out = std::fopen(path, "w");
+		if (!out) return false;
+
+		std::lock_guard<std::mutex> buffersLock{ gBuffersMutex };
+		std::lock_guard<std::mutex> stringsLock{ gStringsMutex };
+
+		// Complete events ("X") in microseconds, one track per thread in the order threads first recorded
+		std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+		bool first{ true };
+		for (const auto& b : gBuffers) {
+			std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+						 first ? "" : ",\n", b->tid, b->tid);
+			first = false;
+
+			for (const chunk* c = b->head.get(); c; c = c->next.load(std::memory_order_acquire)) {
+				const u32 count = c->count.load(std::memory_order_acquire);
+				for (u32 i{ 0 };i < count;++i) {
+					const event& e = c->events[i];
+					std::fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"ContentTool\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+								 e.name, b->tid, e.begin / 1e3, (e.end - e.begin) / 1e3);
+					if (e.arg && e.arg < gStrings.size()) {
+						std::fputs(",\"args\":{\"file\":", out);
+						write_json_string(out, gStrings[e.arg]);
+						std::fputc('}', out);
+					}
+					std::fputc('}', out);
+				}
+			}
+		}
+		std::fputs("\n]}\n", out);
+		return std::fclose(out) == 0;
+	}
+
+	namespace detail {
+		u64 now() {
+			return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gEpoch).count());
+		}
+
+		u32 intern(const char* text) {
+			if (!text) return 0;
+			std::lock_guard<std::mutex> lock{ gStringsMutex };
+			auto found = gStringIds.find(text);
+			if (found != gStringIds.end()) return found->second;
+
+			const u32 id = u32(gStrings.size());
+			gStringIds.emplace(gStrings.emplace_back(text), id);
+			return id;
+		}
+
+		void record(const char* name, u32 arg, u64 begin, u64 end) {
+			thread_buffer& b = buffer();
+			u32 n = b.tail->count.load(std::memory_order_relaxed);
+			if (n == chunk::CAPACITY) {
+				b.more.push_back(std::make_unique<chunk>());
+				chunk* c = b.more.back().get();
+				b.tail->next.store(c, std::memory_order_release);
+				b.tail = c;
+				n = 0;
+			}
+			b.tail->events[n] = event{ name, arg, begin, end };
+			b.tail->count.store(n + 1, std::memory_order_release);
+		}
+	}
+}
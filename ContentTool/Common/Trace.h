@@ -0,0 +1,62 @@
+#pragma once
+#include "PrimitiveTypes.h"
+#include <atomic>
+
+// Builds without the tracer compile every zone down to nothing
+#ifndef TOOLS_WITH_TRACE
+#define TOOLS_WITH_TRACE 1
+#endif
+
+namespace tools::trace {
+
+	// Timeline of what every thread did between start() and write(), as Chrome trace_event JSON
+	// (chrome://tracing, ui.perfetto.dev). Each thread appends its zones to a buffer of its own, nothing
+	// is shared or locked while recording except the first zone of a thread and interning file names,
+	// which stores each name once.
+	// start() and write() are meant to be called between runs, not while threads are recording.
+
+	// Drops whatever was recorded and starts recording
+	void start();
+	// Stops recording, what was recorded stays until the next start()
+	void stop();
+	// Writes what was recorded to 'path', replacing it. Returns false if the file can't be written.
+	[[nodiscard]] bool write(const char* path);
+
+	namespace detail {
+		inline std::atomic<bool> recording{ false };
+
+		[[nodiscard]] u64 now(); // ns since start()
+		[[nodiscard]] u32 intern(const char* text); // 0 for null
+		void record(const char* name, u32 arg, u64 begin, u64 end);
+	}
+
+#if TOOLS_WITH_TRACE
+	// Records the time from construction to destruction on the calling thread. 'name' must be a literal,
+	// 'file' is copied and shows up as the zone's argument.
+	class zone {
+	public:
+		explicit zone(const char* name, const char* file = nullptr) {
+			if (!detail::recording.load(std::memory_order_relaxed)) return;
+			_name = name;
+			_arg = detail::intern(file);
+			_begin = detail::now();
+		}
+		~zone() {
+			if (_name) detail::record(_name, _arg, _begin, detail::now());
+		}
+
+		zone(const zone&) = delete;
+		zone& operator=(const zone&) = delete;
+
+	private:
+		const char*		_name{ nullptr }; // null while not recording
+		u32				_arg{ 0 };
+		u64				_begin{ 0 };
+	};
+#else
+	class zone {
+	public:
+		explicit zone(const char*, const char* = nullptr) {}
+	};
+#endif
+}
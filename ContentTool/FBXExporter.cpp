@@ -1,17 +1,24 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
-#include <Windows.h>
 #include "FBXExporter.h"
 #include "HGR/Mesh.h"
+#include "Common/Stats.h"
+#include "Common/Trace.h"
 #include <cmath>
-#include <set>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 
 // If any compilation or linking errors occur, make sure:
 // 1) FBX SDK 2020.2 or later is installed on your system
 // 2) The Include Path to fbxsdk.h is added to the "Additional Include Directories" (Compiler Settings)
 // 3) The Library Paths in the following section point to the correct location
 
+#ifdef _MSC_VER
 #if _DEBUG
 #pragma comment (lib, "C:\\Program Files\\Autodesk\\FBX\\FBX SDK\\2020.3.7\\lib\\x64\\debug\\libfbxsdk-md.lib")
 #pragma comment (lib, "C:\\Program Files\\Autodesk\\FBX\\FBX SDK\\2020.3.7\\lib\\x64\\debug\\libxml2-md.lib")
@@ -21,6 +28,7 @@
 #pragma comment (lib, "C:\\Program Files\\Autodesk\\FBX\\FBX SDK\\2020.3.7\\lib\\x64\\release\\libxml2-md.lib")
 #pragma comment (lib, "C:\\Program Files\\Autodesk\\FBX\\FBX SDK\\2020.3.7\\lib\\x64\\release\\zlib-md.lib")
 #endif // _DEBUG
+#endif // _MSC_VER, other toolchains link the SDK through CMakeLists.txt
 
 // After linking, it may throw warnings regarding pdb symbols being not found. to fix this, either
 // 1) download the symbols from Autodesk's website
@@ -33,6 +41,10 @@ namespace tools {
         // static const char* gAmbientElementName = "AmbientUV";
         // static const char* gEmissiveElementName = "EmissiveUV";
 
+        // The FBX SDK isn't thread safe, so batch conversions parse in parallel but
+        // build and write their scenes one at a time.
+        std::mutex gFbxMutex;
+
         class Exporter {
         public:
 
@@ -62,6 +74,8 @@ namespace tools {
             // Exports a scene to an FBX file
             bool SaveScene( FbxManager* pSdkManager, FbxScene* pScene, const char* pFilename, 
                             int pFileFormat, bool pEmbedMedia = false ) {
+                stats::scoped_timer timer{ stats::TIMER_FBX_SAVE };
+                trace::zone zone{ "fbx.save", pFilename };
                 int lMajor, lMinor, lRevision;
                 bool lStatus = true;
 
@@ -89,7 +103,7 @@ namespace tools {
                     }
                 }
 
-                _outPath = _outPath + "\\" + pFilename;
+                _outPath = (std::filesystem::path(_outPath) / pFilename).string();
                 // Initialize the exporter by providing a filename.
                 if (lExporter->Initialize(_outPath.c_str(), pFileFormat, pSdkManager->GetIOSettings()) == false)
                 {
@@ -124,63 +138,68 @@ namespace tools {
             }
 
             bool CreateScene(FbxScene*& pScene) {
+                stats::scoped_timer timer{ stats::TIMER_FBX_SCENE };
+                trace::zone zone{ "fbx.scene" };
                 lRootNode = pScene->GetRootNode();
 
-                // Can you build a node tree?
-                for (auto hgrNode : _assets.Nodes) {
-                    CreateHGRNode(pScene, hgrNode);
+                // Build the node tree in one pass, parents before their children
+                const hgr::node_hierarchy& hierarchy = _assets->hierarchy;
+                _nodes.assign(hierarchy.size(), nullptr);
+                _nodeIndex.clear();
+                _nodeIndex.reserve(hierarchy.size());
+
+                {
+                    stats::scoped_timer nodesTimer{ stats::TIMER_FBX_NODES };
+                    trace::zone nodesZone{ "fbx.nodes" };
+                    hierarchy.depth_first([&](u32 i) {
+                        const u32 parent = hierarchy.parents[i];
+                        FbxNode* lParent = parent == u32_invalid_id ? lRootNode : _nodes[parent];
+
+                        _nodes[i] = CreateNode(pScene, i);
+                        lParent->AddChild(_nodes[i]);
+                        _nodeIndex.try_emplace(_assets->Nodes.names[i], i); // the first node wins if names repeat
+                    });
                 }
 
-                for (u32 i = 0; i < (_assets.entityInfo->TransformAnimation_Count); ++i) {
-                    AnimateHGRNode(pScene, _assets.transAnim[i]);
+                for (u32 i = 0; i < (_assets->entityInfo->TransformAnimation_Count); ++i) {
+                    AnimateHGRNode(pScene, _assets->transAnim[i]);
                 }
 
                 return true;
             }
 
-            FbxNode* CreateHGRNode(FbxScene*& pScene, hgr::node& hgrNode) { // Recursive Function to create the tree structure
-                if (_uid.contains(hgrNode.name)) {
-                    if (hgrNode.parentIndex == 4294967295) {
-                        return lRootNode->FindChild(hgrNode.name.c_str()); // returns parent node if exists
-                    } else {
-                        FbxNode* lParent = CreateHGRNode(pScene, _assets.Nodes[hgrNode.parentIndex]); // Create or Find Parent Node
-                        return lParent->FindChild(hgrNode.name.c_str());
-                    }
-                }
-
-                // if Node doesn't exist :
-                if (hgrNode.parentIndex == 4294967295) {
-                    FbxNode* lNode = CreateNode(pScene, hgrNode);
-                    lRootNode->AddChild(lNode);
-                    _uid.insert(hgrNode.name);
-                    return lNode;
-                } else {
-                    FbxNode* lParent = CreateHGRNode(pScene, _assets.Nodes[hgrNode.parentIndex]); // Create or Find Parent Node
-                    assert(lParent);
-                    FbxNode* lNode = CreateNode(pScene, hgrNode);
-                    lParent->AddChild(lNode);
-                    _uid.insert(hgrNode.name);
-                    return lNode;
-                }
+            // The FbxNode created for the HGR node with that name, nullptr if there is none
+            [[nodiscard]]
+            FbxNode* FindHGRNode(std::string_view name) const {
+                auto it = _nodeIndex.find(name);
+                return it != _nodeIndex.end() ? _nodes[it->second] : nullptr;
             }
 
             [[nodiscard]]
-            FbxNode* CreateNode(FbxScene*& pScene, hgr::node hgrNode) {
-                FbxNode* lNode = FbxNode::Create(pScene, hgrNode.name.c_str());
+            FbxNode* CreateNode(FbxScene*& pScene, u32 nodeIndex) {
+                const hgr::node_table& nodes = _assets->Nodes;
+                const u32 payload = nodes.payloads[nodeIndex]; // into the array of the section the node came from
+                FbxNode* lNode = FbxNode::Create(pScene, nodes.names[nodeIndex].c_str());
+                stats::add(stats::COUNTER_FBX_NODES, 1);
 
                 // TODO: Complete implementation of other types
-                // Type of NODE to add Attribute
-                switch (hgrNode.classID) {
+                // Type of NODE to add Attribute. By the section the node was read from, the class in its
+                // flags doesn't have to match the array payload indexes.
+                const hgr::entity_info& count = *_assets->entityInfo;
+                switch (nodes.payloadClass[nodeIndex]) {
                     case hgr::NODE_MESH:
-                        CreateHGRMesh(pScene, _assets.meshInfo[hgrNode.index], lNode);
+                        if (payload >= count.Mesh_Count) throw std::runtime_error("Failed: mesh node out of range");
+                        CreateHGRMesh(pScene, _assets->meshInfo[payload], lNode);
                     break;
 
                     case hgr::NODE_CAMERA:
-                        CreateCamera(pScene, _assets.cameraInfo[hgrNode.index], lNode);
+                        if (payload >= count.Camera_Count) throw std::runtime_error("Failed: camera node out of range");
+                        CreateCamera(pScene, _assets->cameraInfo[payload], lNode);
                     break;
 
                     case hgr::NODE_LIGHT:
-                        CreateLight(pScene, _assets.lightInfo[hgrNode.index], lNode);
+                        if (payload >= count.Light_Count) throw std::runtime_error("Failed: light node out of range");
+                        CreateLight(pScene, _assets->lightInfo[payload], lNode);
                     break;
 
                     case hgr::NODE_LINES:
@@ -198,7 +217,7 @@ namespace tools {
                     break;
                 }
 
-                SetTransform(lNode, hgrNode.modeltm);
+                SetTransform(lNode, nodes.modeltm[nodeIndex]);
 
                 return lNode;
             }
@@ -207,7 +226,7 @@ namespace tools {
             // More specifically it occurs when the X-axis of an MTi points straight up or straight down, i.e. Pitch = +-90 deg.
 
             [[nodiscard]]
-            FbxVector4 Rot3x3toQuaternion(math::float3x4 modeltm) {
+            FbxVector4 Rot3x3toQuaternion(const math::float3x4& modeltm) {
                 FbxVector4 q(0, 0, 0, 0);
                 double t = 0;
 
@@ -238,7 +257,7 @@ namespace tools {
             }
 
             [[nodiscard]]
-            FbxVector4 QuaterniontoEuler(FbxVector4 quat) {
+            FbxVector4 QuaterniontoEuler(const FbxVector4& quat) {
                 FbxVector4 e(0, 0, 0, 0);
                 double t0, t1, t2, t3, t4;
                 double X, Y, Z;
@@ -262,11 +281,11 @@ namespace tools {
             }
 
             [[nodiscard]]
-            FbxVector4 Rot3x3toDegrees(math::float3x4 modeltm) {
+            FbxVector4 Rot3x3toDegrees(const math::float3x4& modeltm) {
                 return QuaterniontoEuler(Rot3x3toQuaternion(modeltm));
             }
 
-            void SetTransform(FbxNode*& lNode, math::float3x4 modeltm)
+            void SetTransform(FbxNode*& lNode, const math::float3x4& modeltm)
             {
                 FbxVector4 Position(modeltm.w[0], modeltm.w[1], modeltm.w[2]);
                 FbxVector4 Rotation = Rot3x3toDegrees(modeltm);
@@ -277,197 +296,205 @@ namespace tools {
                 lNode->LclScaling.Set(Scale);
             }
 
-            void CreateHGRMesh(FbxScene*& pScene, hgr::mesh& hgrMesh, FbxNode*& lNode) {
-                hgr::material_info mat_info;
-                hgr::texture_info tex_info;
+            // Primitive i of the mesh. The file numbers them, so a number past the primitive table fails the export.
+            [[nodiscard]]
+            const hgr::primitive_info& Primitive(const hgr::mesh& hgrMesh, u32 i) const {
+                const u32 prim = hgrMesh.primIndex[i];
+                if (prim >= _assets->primInfo.size()) throw std::runtime_error("Failed: primitive index out of range");
+                return _assets->primInfo[prim];
+            }
 
-                for (u32 i{ 0 };i < hgrMesh.primCount;++i) {
-                    u32 primitiveID = hgrMesh.primIndex[i];
+            void CreateHGRMesh(FbxScene*& pScene, const hgr::mesh& hgrMesh, FbxNode*& lNode) {
+                // All primitives of the mesh go into one FbxMesh, their materials become the node's materials
+                FbxMesh* lMesh = CreateMesh(pScene, _assets->Nodes.names[hgrMesh.nodeIndex].c_str(), hgrMesh);
 
-                    mat_info = _assets.matInfo[_assets.primInfo[primitiveID].matIndex];
-                    tex_info = _assets.texInfo[mat_info.TexParams[0].texIndex];
+                lNode->SetNodeAttribute(lMesh);
+                lNode->SetShadingMode(FbxNode::eTextureShading);
+                lNode->mCullingType = FbxNode::eCullingOnCCW;
+
+                // Each polygon picks one of the node's materials
+                FbxGeometryElementMaterial* lMaterialElement = lMesh->CreateElementMaterial();
+                lMaterialElement->SetMappingMode(FbxGeometryElement::eByPolygon);
+                lMaterialElement->SetReferenceMode(FbxGeometryElement::eIndexToDirect);
 
-                    FbxMesh* lMesh = CreateMesh(pScene, hgrMesh.name.c_str(), _assets.primInfo[primitiveID],
-                                                   mat_info, tex_info);
+                std::vector<u16> slots; // matIndex of each node material, a mesh only uses a handful
+                for (u32 i{ 0 };i < hgrMesh.primCount;++i) {
+                    const hgr::primitive_info& prim_info = Primitive(hgrMesh, i);
 
-                    lNode->SetNodeAttribute(lMesh);
-                    lNode->SetShadingMode(FbxNode::eTextureShading);
+                    int slot = int(std::find(slots.begin(), slots.end(), prim_info.matIndex) - slots.begin());
+                    if (slot == int(slots.size())) {
+                        lNode->AddMaterial(GetHGRMaterial(pScene, prim_info.matIndex));
+                        slots.push_back(prim_info.matIndex);
+                    }
 
-                    CreateHGRTexture(pScene, lMesh, mat_info, (_texPath + "\\" + (tex_info.name).substr(0, tex_info.name.length() - 4) + ".jpg").c_str());
+                    for (u32 j{ 0 };j < prim_info.indices / 3;++j) {
+                        lMaterialElement->GetIndexArray().Add(slot);
+                    }
                 }
             }
 
+            // Concatenates the primitives of hgrMesh: their vertices are appended as control points
+            // and their triangles become polygons, in primitive order
             [[nodiscard]]
-            FbxMesh* CreateMesh(FbxScene* pScene, const char* pName, hgr::primitive_info prim_info,
-                                hgr::material_info mat_info, hgr::texture_info tex_info) {
+            FbxMesh* CreateMesh(FbxScene* pScene, const char* pName, const hgr::mesh& hgrMesh) {
 
                 // Mesh -> node
                 // Vertices -> control points
                 // Normal, Diffuse, Ambient -> FbxGeometryElements
 
+                using geometry = hgr::primitive_geometry;
 
-                u32 i{ 0 }; int pos{ -1 }; int tex0{ -1 }; int j{ 0 };
+                u32 i{ 0 }; int j{ 0 };
                 FbxMesh* lMesh = FbxMesh::Create(pScene, pName); // Object Container -> pScene
-
-                std::vector<FbxVector4> lVertices;
-                std::vector<FbxVector2> lVectors;
-
-                for (i = 0; i < prim_info.formatCount; ++i) {
-                    if (VertexFormat::toDataType(prim_info.formats[i].type.c_str()) == VertexFormat::DT_POSITION) {
-                        pos = i;
+                stats::add(stats::COUNTER_FBX_MESHES, 1);
+
+                u32 verts{ 0 }, indices{ 0 };
+                for (u32 p{ 0 };p < hgrMesh.primCount;++p) {
+                    const hgr::primitive_info& prim_info = Primitive(hgrMesh, p);
+                    assert(prim_info.primitiveType == tools::hgr::Mesh::PRIM_TRI);
+                    if (!prim_info.geometry.has(geometry::POSITION) || !prim_info.geometry.has(geometry::UV0)) {
+                        throw std::runtime_error("Failed: primitive without positions or UVs");
                     }
-                    else if (VertexFormat::toDataType(prim_info.formats[i].type.c_str()) == VertexFormat::DT_TEX0) {
-                        tex0 = i;
-                    }
-                }
-                assert(pos != -1 && tex0 != -1);
-
-                s16* buf = prim_info.vArray[pos].value;
-
-                // Create Control Points from Vertices
-                for (i = 0; i < prim_info.verts; ++i) {
-                    lVertices.push_back({ (*buf++) * prim_info.vArray[pos].scale + prim_info.vArray[pos].bias[0],
-                                          (*buf++) * prim_info.vArray[pos].scale + prim_info.vArray[pos].bias[1],
-                                          (*buf++) * prim_info.vArray[pos].scale + prim_info.vArray[pos].bias[2] });
+                    verts += prim_info.verts;
+                    indices += prim_info.indices;
                 }
 
-                // Map Vertices to Faces/Indices
-                lMesh->InitControlPoints(prim_info.indices);
+                lMesh->InitControlPoints(verts);
                 FbxVector4* lControlPoints = lMesh->GetControlPoints();
 
-                // Create Array of Polygon Vertices / Vertex Indices
-                int* lPolygonVertices = new int[prim_info.indices];
-
-                for (i = 0;i < prim_info.indices;++i) {
-                    lControlPoints[i] = lVertices[prim_info.indexData[i]]; // Set using IndexData
-                    lPolygonVertices[i] = i;
-                }
-
                 // Set Normals -> is it necessary to assign if i'm generating at a later stage
                 //FbxGeometryElementNormal* lGeometryElementNormal = lMesh->CreateElementNormal();
                 //lGeometryElementNormal->SetMappingMode(FbxGeometryElement::eNone);
 
                 // Create UV for Diffuse Channel, Ambient Channel and Emissive Channel [idk if there are any more]
 
-                // Diffuse channel - manually assign UV co-ords
+                // Diffuse channel - HGR vertices are already split along UV seams, so every control point
+                // has exactly one UV and they can be mapped one to one
                 FbxGeometryElementUV* lUVDiffuseElement = lMesh->CreateElementUV(gDiffuseElementName);
                 FBX_ASSERT(lUVDiffuseElement != NULL);
-                lUVDiffuseElement->SetMappingMode(FbxGeometryElement::eByPolygonVertex);
-                lUVDiffuseElement->SetReferenceMode(FbxGeometryElement::eIndexToDirect);
-
-                buf = prim_info.vArray[tex0].value;
-                double x, y;
+                lUVDiffuseElement->SetMappingMode(FbxGeometryElement::eByControlPoint);
+                lUVDiffuseElement->SetReferenceMode(FbxGeometryElement::eDirect);
+                lUVDiffuseElement->GetDirectArray().SetCount(verts);
+
+                lMesh->ReservePolygonCount(indices / 3);
+                lMesh->ReservePolygonVertexCount(indices);
+
+                u32 base{ 0 }; // first control point of the current primitive
+                for (u32 p{ 0 };p < hgrMesh.primCount;++p) {
+                    const hgr::primitive_info& prim_info = Primitive(hgrMesh, p);
+                    const geometry& geo = prim_info.geometry;
+
+                    // Create Control Points from Vertices - one per vertex, shared by every triangle using it
+                    const f32* px = geo.get(geometry::POSITION, 0);
+                    const f32* py = geo.get(geometry::POSITION, 1);
+                    const f32* pz = geo.get(geometry::POSITION, 2);
+                    const f32* u = geo.get(geometry::UV0, 0);
+                    const f32* v = geo.get(geometry::UV0, 1);
+                    for (i = 0; i < prim_info.verts; ++i) {
+                        lControlPoints[base + i] = FbxVector4(px[i], py[i], pz[i]);
+                        //lUVDiffuseElement->GetDirectArray().SetAt(base + i, { -v[i] + 1.0, u[i] });
+                        lUVDiffuseElement->GetDirectArray().SetAt(base + i, FbxVector2(u[i], 1.0 - v[i]));
+                    }
 
-                for (i = 0; i < prim_info.verts; ++i) {
-                    x = ((*buf++) * prim_info.vArray[tex0].scale) + prim_info.vArray[tex0].bias[0];
-                    y = ((*buf++) * prim_info.vArray[tex0].scale) + prim_info.vArray[tex0].bias[1];
+                    // Create Polygons from the index data
+                    for (i = 0; i < (prim_info.indices / 3); i++) // It's a trigon
+                    {
+                        lMesh->BeginPolygon(-1, -1, false);
+
+                        // Invert Faces / Normals Direction
+                        // Writing in inverse order
+                        for (j = 2; j >= 0; --j) {
+                            const u16 index = prim_info.indexData[i * 3 + j];
+                            if (index >= prim_info.verts) throw std::runtime_error("Failed: vertex index out of range");
+                            lMesh->AddPolygon(base + index);
+                        }
 
-                    //lVectors.push_back({ -y + 1.0, x });
-                    lVectors.push_back({ x, 1.0 - y });
-                }
+                        lMesh->EndPolygon();
+                    }
 
-                for (i = 0; i < (prim_info.indices / 3); ++i) {
-                    lUVDiffuseElement->GetDirectArray().Add(lVectors[prim_info.indexData[i * 3 + 2]]);
-                    lUVDiffuseElement->GetDirectArray().Add(lVectors[prim_info.indexData[i * 3 + 1]]);
-                    lUVDiffuseElement->GetDirectArray().Add(lVectors[prim_info.indexData[i * 3 + 0]]);
+                    base += prim_info.verts;
                 }
+                assert(base == verts);
 
-                lUVDiffuseElement->GetIndexArray().SetCount(prim_info.indices); // Resize
+                return lMesh;
+            }
 
-                // Create Polygon and Map UVs
-                assert(prim_info.primitiveType == tools::hgr::Mesh::PRIM_TRI);
-                for (i = 0; i < (prim_info.indices / 3); i++) // It's a trigon
-                {
-                    // we won't use the default way of assigning textures, as we have
-                    // textures on more than just the default (diffuse) channel.
-                    lMesh->BeginPolygon(-1, -1, false);
-
-                    // Invert Faces / Normals Direction
-                    // Writing in inverse order
-                    for (j = 2; j >= 0; --j) {
-                        // this function points 
-                        lMesh->AddPolygon(lPolygonVertices[i * 3 + j]); // For each index
-
-                        // Update the index array of the UVs for diffuse, ambient and emissive
-                        lUVDiffuseElement->GetIndexArray().SetAt(i * 3 + j, i * 3 + j);
+            // Every HGR material becomes one FbxSurfacePhong for the whole scene, created the first time a
+            // primitive uses it and connected to every node after that
+            [[nodiscard]]
+            FbxSurfacePhong* GetHGRMaterial(FbxScene* pScene, u16 matIndex) {
+                if (matIndex >= _assets->matInfo.size()) throw std::runtime_error("Failed: material index out of range");
+                if (matIndex >= _materials.size()) _materials.resize(size_t(matIndex) + 1, nullptr);
+
+                FbxSurfacePhong*& lMaterial = _materials[matIndex];
+                if (!lMaterial) {
+                    const hgr::material_info& mat_info = _assets->matInfo[matIndex];
+                    std::string texture{};
+                    if (mat_info.texParamCount > 0) {
+                        const hgr::texture_info& tex_info = _assets->texInfo[mat_info.TexParams[0].texIndex];
+                        texture = (std::filesystem::path(_texPath) / (tex_info.name.substr(0, tex_info.name.length() - 4) + ".jpg")).string();
                     }
-
-                    //for (j = 0; j < 3; ++j) {
-                    //    // Update the index array of the UVs for diffuse, ambient and emissive
-                    //    lUVDiffuseElement->GetIndexArray().SetAt(i * 3 + j, j);
-                    //}
-
-                    lMesh->EndPolygon();
+                    lMaterial = CreateHGRMaterial(pScene, mat_info, texture.empty() ? nullptr : texture.c_str());
                 }
-                assert(i == (prim_info.indices / 3));
-
-                delete[] lPolygonVertices;
-                lVectors.clear();
-                lVertices.clear();
-                return lMesh;
+                return lMaterial;
             }
 
             // Fix Wrong Blend Mode being used -> Occurs due to using PNG instead of JPG
-            void CreateHGRTexture(FbxScene* pScene, FbxMesh* pMesh, hgr::material_info hgrMaterial, const char* texture) {
-                FbxSurfacePhong* lMaterial = NULL;
-
-                //get the node of mesh, add material for it.
-                FbxNode* lNode = pMesh->GetNode();
-                lNode->mCullingType = FbxNode::eCullingOnCCW;
-                if (lNode) {
-                    lMaterial = lNode->GetSrcObject<FbxSurfacePhong>(0);
-                    if (lMaterial == NULL) {
-                        FbxString lMaterialName = hgrMaterial.name.c_str();
-                        FbxString lShadingName = hgrMaterial.shaderName.c_str();
-                        FbxDouble3 lBlack(0.0, 0.0, 0.0);
-                        FbxDouble3 lRed(1.0, 0.0, 0.0);
-                        FbxDouble3 lDiffuseColor(0.75, 0.75, 0.0);
-
-                        FbxLayer* lLayer = pMesh->GetLayer(0);
-
-                        // Create a layer element material to handle proper mapping.
-                        FbxLayerElementMaterial* lLayerElementMaterial = FbxLayerElementMaterial::Create(pMesh, lMaterialName.Buffer());
-                        lLayerElementMaterial->SetMappingMode(FbxLayerElement::eAllSame);
-                        lLayerElementMaterial->SetReferenceMode(FbxLayerElement::eIndexToDirect);
-
-                        lLayer->SetMaterials(lLayerElementMaterial);
-                        lLayerElementMaterial->GetIndexArray().Add(0);
-
-                        lMaterial = FbxSurfacePhong::Create(pScene, lMaterialName.Buffer());
-
-                        lMaterial->AmbientFactor.Set(1.0);
-                        lMaterial->DiffuseFactor.Set(1.0);
-                        lMaterial->TransparencyFactor.Set(0.4);
-
-                        lMaterial->ShadingModel.Set(lShadingName);
-                        lMaterial->Shininess.Set(0.5);
-                        lMaterial->SpecularFactor.Set(0.3);
-
-                        for (int i = 0; i < hgrMaterial.vec4ParamCount;++i) {
-                            if (hgrMaterial.Vec4Params[i].param_type == "AMBIENTC") {
-                                FbxDouble3 lAmbient(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
-                                lMaterial->Ambient.Set(lAmbient);
-                                lMaterial->AmbientFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
-                            } else if (hgrMaterial.Vec4Params[i].param_type == "DIFFUSEC") {
-                                FbxDouble3 lDiffuse(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
-                                lMaterial->Diffuse.Set(lDiffuse);
-                                //lMaterial->TransparencyFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
-                            } else if (hgrMaterial.Vec4Params[i].param_type == "SPECULARC") {
-                                FbxDouble3 lSpecular(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
-                                lMaterial->Specular.Set(lSpecular);
-                                lMaterial->SpecularFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
-                            } else assert(false && "Vector 4 Parameter not implemented!");
-                        }
+            [[nodiscard]]
+            FbxSurfacePhong* CreateHGRMaterial(FbxScene* pScene, const hgr::material_info& hgrMaterial, const char* texture) {
+                FbxString lMaterialName = hgrMaterial.name.c_str();
+                FbxString lShadingName = hgrMaterial.shaderName.c_str();
+
+                FbxSurfacePhong* lMaterial = FbxSurfacePhong::Create(pScene, lMaterialName.Buffer());
+                stats::add(stats::COUNTER_FBX_MATERIALS, 1);
+
+                lMaterial->AmbientFactor.Set(1.0);
+                lMaterial->DiffuseFactor.Set(1.0);
+                lMaterial->TransparencyFactor.Set(0.4);
+
+                lMaterial->ShadingModel.Set(lShadingName);
+                lMaterial->Shininess.Set(0.5);
+                lMaterial->SpecularFactor.Set(0.3);
+
+                for (int i = 0; i < hgrMaterial.vec4ParamCount;++i) {
+                    if (hgrMaterial.Vec4Params[i].param_type == "AMBIENTC") {
+                        FbxDouble3 lAmbient(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
+                        lMaterial->Ambient.Set(lAmbient);
+                        lMaterial->AmbientFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
+                    } else if (hgrMaterial.Vec4Params[i].param_type == "DIFFUSEC") {
+                        FbxDouble3 lDiffuse(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
+                        lMaterial->Diffuse.Set(lDiffuse);
+                        //lMaterial->TransparencyFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
+                    } else if (hgrMaterial.Vec4Params[i].param_type == "SPECULARC") {
+                        FbxDouble3 lSpecular(hgrMaterial.Vec4Params[i].value[0], hgrMaterial.Vec4Params[i].value[1], hgrMaterial.Vec4Params[i].value[2]);
+                        lMaterial->Specular.Set(lSpecular);
+                        lMaterial->SpecularFactor.Set(hgrMaterial.Vec4Params[i].value[3]);
+                    } else assert(false && "Vector 4 Parameter not implemented!");
+                }
 
-                        for (int i = 0; i < hgrMaterial.floatParamCount;++i) {
-                            if(hgrMaterial.FloatParams[i].param_type == "SHININESS") lMaterial->Shininess.Set(hgrMaterial.FloatParams[i].value);
-                        }
+                for (int i = 0; i < hgrMaterial.floatParamCount;++i) {
+                    if(hgrMaterial.FloatParams[i].param_type == "SHININESS") lMaterial->Shininess.Set(hgrMaterial.FloatParams[i].value);
+                }
 
-                        lNode->AddMaterial(lMaterial);
-                    }
+                if (texture) {
+                    // don't forget to connect the texture to the corresponding property of the material
+                    lMaterial->Diffuse.ConnectSrcObject(GetHGRTexture(pScene, texture));
                 }
+                return lMaterial;
+            }
 
+            // One FbxFileTexture per texture file, shared by all materials using it
+            [[nodiscard]]
+            FbxFileTexture* GetHGRTexture(FbxScene* pScene, const char* texture) {
+                FbxFileTexture*& lTexture = _textures[texture];
+                if (!lTexture) lTexture = CreateHGRTexture(pScene, texture);
+                return lTexture;
+            }
+
+            [[nodiscard]]
+            FbxFileTexture* CreateHGRTexture(FbxScene* pScene, const char* texture) {
                 FbxFileTexture* lTexture = FbxFileTexture::Create(pScene, "Diffuse Texture");
+                stats::add(stats::COUNTER_FBX_TEXTURES, 1);
 
                 // Set texture properties.
                 lTexture->SetFileName(texture);
@@ -481,16 +508,15 @@ namespace tools {
                 lTexture->SetRotation(0.0, 0.0);
 
                 lTexture->UVSet.Set(FbxString(gDiffuseElementName)); // Connect texture to the proper UV
-
-                // don't forget to connect the texture to the corresponding property of the material
-                if (lMaterial) lMaterial->Diffuse.ConnectSrcObject(lTexture);
+                return lTexture;
             }
 
-            void CreateCamera(FbxScene*& pScene, hgr::camera& hgrCamera, FbxNode*& lNode)
+            void CreateCamera(FbxScene*& pScene, const hgr::camera& hgrCamera, FbxNode*& lNode)
             {
                 if (!pScene) return;
 
-                FbxCamera* lCamera = FbxCamera::Create(pScene, hgrCamera.name.c_str());
+                FbxCamera* lCamera = FbxCamera::Create(pScene, _assets->Nodes.names[hgrCamera.nodeIndex].c_str());
+                stats::add(stats::COUNTER_FBX_CAMERAS, 1);
                 lNode->SetNodeAttribute(lCamera);
 
                 lCamera->SetFormat(FbxCamera::eHD);
@@ -506,9 +532,10 @@ namespace tools {
                 // hgrCamera.front & hgrCamera.back
             }
 
-            void CreateLight(FbxScene*& pScene, hgr::light& hgrLight, FbxNode*& lNode)
+            void CreateLight(FbxScene*& pScene, const hgr::light& hgrLight, FbxNode*& lNode)
             {
-                FbxLight* lLight = FbxLight::Create(pScene, hgrLight.name.c_str());
+                FbxLight* lLight = FbxLight::Create(pScene, _assets->Nodes.names[hgrLight.nodeIndex].c_str());
+                stats::add(stats::COUNTER_FBX_LIGHTS, 1);
 
                 lLight->LightType.Set(FbxLight::eSpot);
                 lLight->CastLight.Set(true);
@@ -527,9 +554,11 @@ namespace tools {
                 lNode->SetNodeAttribute(lLight);
             }
 
-            void AnimateHGRNode(FbxScene*& pScene, tools::hgr::transformAnimation transAnim) {
-                FbxNode* root = pScene->GetRootNode();
-                FbxNode* animNode = root->FindChild(transAnim.nodeName.c_str());
+            void AnimateHGRNode(FbxScene*& pScene, const tools::hgr::transformAnimation& transAnim) {
+                FbxNode* animNode = FindHGRNode(transAnim.nodeName);
+                if (!animNode) return;
+                stats::scoped_timer timer{ stats::TIMER_FBX_ANIMATION };
+                trace::zone zone{ "fbx.animation" };
 
                 // Create the Animation Stack
                 FbxAnimStack* lAnimStack = FbxAnimStack::Create(pScene, transAnim.nodeName.c_str());
@@ -547,6 +576,9 @@ namespace tools {
                 int i;
                 int lKeyIndex = 0;
 
+                const std::vector<tools::math::float4>& posKeys = hgr::position_keys(transAnim);
+                const std::vector<tools::math::float4>& sclKeys = hgr::scale_keys(transAnim);
+
                 // Animate Position
                 {
                     animNode->LclTranslation.GetCurveNode(lAnimLayer, true); // Creates the Curve Node when true
@@ -554,33 +586,34 @@ namespace tools {
                     lCurve_X = animNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
                     lCurve_Y = animNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
                     lCurve_Z = animNode->LclTranslation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+                    stats::add(stats::COUNTER_FBX_CURVES, 3);
 
                     lCurve_X->KeyModifyBegin();
                     lCurve_Y->KeyModifyBegin();
                     lCurve_Z->KeyModifyBegin();
 
-                    for (i = 0; i < transAnim.posKeyData->keyCount; i++) {
+                    for (i = 0; i < int(posKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_X->KeyAdd(lTime);
 
-                        lCurve_X->KeySetValue(lKeyIndex, transAnim.posKeyData->keys[i].x);
+                        lCurve_X->KeySetValue(lKeyIndex, posKeys[i].x);
                         lCurve_X->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
 
-                    for (i = 0; i < transAnim.posKeyData->keyCount; i++) {
+                    for (i = 0; i < int(posKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Y->KeyAdd(lTime);
 
-                        lCurve_Y->KeySetValue(lKeyIndex, transAnim.posKeyData->keys[i].y);
+                        lCurve_Y->KeySetValue(lKeyIndex, posKeys[i].y);
                         lCurve_Y->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
-                    for (i = 0; i < transAnim.posKeyData->keyCount; i++) {
+                    for (i = 0; i < int(posKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Z->KeyAdd(lTime);
 
-                        lCurve_Z->KeySetValue(lKeyIndex, transAnim.posKeyData->keys[i].z);
+                        lCurve_Z->KeySetValue(lKeyIndex, posKeys[i].z);
                         lCurve_Z->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
@@ -593,9 +626,9 @@ namespace tools {
                 {
                     // Quaternion to Degrees
                     //
-                    std::vector<FbxVector4> rotKeyData;
-                    rotKeyData.reserve(transAnim.rotKeyData->keyCount);
-                    if (transAnim.rotKeyData->dataFormat == "DF_V4_32") {
+                    std::vector<FbxVector4> rotKeyData; // stays empty unless the keys are quaternions
+                    if (transAnim.rotKeyData && transAnim.rotKeyData->dataFormat == VertexFormat::DF_V4_32) {
+                        rotKeyData.reserve(transAnim.rotKeyData->keys.size());
                         for (auto key : transAnim.rotKeyData->keys) {
                             FbxVector4 rotKey(key.x, key.y, key.z, key.w);
                             rotKey = QuaterniontoEuler(rotKey);
@@ -610,12 +643,13 @@ namespace tools {
                     lCurve_X = animNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
                     lCurve_Y = animNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
                     lCurve_Z = animNode->LclRotation.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+                    stats::add(stats::COUNTER_FBX_CURVES, 3);
 
                     lCurve_X->KeyModifyBegin();
                     lCurve_Y->KeyModifyBegin();
                     lCurve_Z->KeyModifyBegin();
 
-                    for (i = 0; i < transAnim.rotKeyData->keyCount; i++) {
+                    for (i = 0; i < int(rotKeyData.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_X->KeyAdd(lTime);
 
@@ -624,7 +658,7 @@ namespace tools {
                     }
 
 
-                    for (i = 0; i < transAnim.rotKeyData->keyCount; i++) {
+                    for (i = 0; i < int(rotKeyData.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Y->KeyAdd(lTime);
 
@@ -632,7 +666,7 @@ namespace tools {
                         lCurve_Y->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
-                    for (i = 0; i < transAnim.rotKeyData->keyCount; i++) {
+                    for (i = 0; i < int(rotKeyData.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Z->KeyAdd(lTime);
 
@@ -652,33 +686,34 @@ namespace tools {
                     lCurve_X = animNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
                     lCurve_Y = animNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
                     lCurve_Z = animNode->LclScaling.GetCurve(lAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+                    stats::add(stats::COUNTER_FBX_CURVES, 3);
 
                     lCurve_X->KeyModifyBegin();
                     lCurve_Y->KeyModifyBegin();
                     lCurve_Z->KeyModifyBegin();
 
-                    for (i = 0; i < transAnim.sclKeyData->keyCount; i++) {
+                    for (i = 0; i < int(sclKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_X->KeyAdd(lTime);
 
-                        lCurve_X->KeySetValue(lKeyIndex, transAnim.sclKeyData->keys[i].x);
+                        lCurve_X->KeySetValue(lKeyIndex, sclKeys[i].x);
                         lCurve_X->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
 
-                    for (i = 0; i < transAnim.sclKeyData->keyCount; i++) {
+                    for (i = 0; i < int(sclKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Y->KeyAdd(lTime);
 
-                        lCurve_Y->KeySetValue(lKeyIndex, transAnim.sclKeyData->keys[i].y);
+                        lCurve_Y->KeySetValue(lKeyIndex, sclKeys[i].y);
                         lCurve_Y->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
-                    for (i = 0; i < transAnim.sclKeyData->keyCount; i++) {
+                    for (i = 0; i < int(sclKeys.size()); i++) {
                         lTime.SetFrame(i);
                         lKeyIndex = lCurve_Z->KeyAdd(lTime);
 
-                        lCurve_Z->KeySetValue(lKeyIndex, transAnim.sclKeyData->keys[i].z);
+                        lCurve_Z->KeySetValue(lKeyIndex, sclKeys[i].z);
                         lCurve_Z->KeySetInterpolation(lKeyIndex, FbxAnimCurveDef::eInterpolationLinear);
                     }
 
@@ -689,14 +724,14 @@ namespace tools {
                 
             }
 
-            // _asset
-            void SetAssets(hgr::assetData assets) { _assets = assets; }
+            // _asset, not copied: the asset has to outlive the export
+            void SetAssets(const hgr::assetData& assets) { _assets = &assets; }
 
             // _texPath
-            void SetTexPath(std::string texPath) { _texPath = texPath; }
+            void SetTexPath(std::string texPath) { _texPath = std::move(texPath); }
 
             // _outPath
-            void SetOutPath(std::string outPath) { _outPath = outPath; }
+            void SetOutPath(std::string outPath) { _outPath = std::move(outPath); }
 
             // gSdkManager
             [[nodiscard]]
@@ -704,33 +739,55 @@ namespace tools {
 
         private:
             FbxNode*                        lRootNode = nullptr;
-            std::set<std::string>           _uid;
             FbxManager*                     gSdkManager = nullptr;
-            hgr::assetData                  _assets;
+            const hgr::assetData*           _assets = nullptr;
             std::string                     _texPath;
             std::string                     _outPath;
+
+            // Scene objects shared between nodes, an Exporter builds a single scene
+            std::vector<FbxSurfacePhong*>                       _materials; // by matIndex
+            std::unordered_map<std::string, FbxFileTexture*>    _textures; // by file path
+            std::vector<FbxNode*>                               _nodes; // by index into _assets->Nodes
+            std::unordered_map<std::string_view, u32>           _nodeIndex; // node name -> index, names live in _assets
         };
 
 	} // Anonymous Namespace
 
-    void CreateFBX(hgr::assetData& asset, const char* path, const char* texpath, const char* outpath) {
+    bool CreateFBX(const hgr::assetData& asset, const char* path, const char* texpath, const char* outpath, fbx_timings* timings) {
+        // The wait shows how long workers stall on the other files' FBX SDK work
+        std::unique_lock<std::mutex> lock{ gFbxMutex, std::defer_lock };
+        {
+            trace::zone zone{ "fbx.wait" };
+            lock.lock();
+        }
+        trace::zone zone{ "CreateFBX" };
+
         // Filter the filename from path
         std::string file = path;
-        file = file.substr(file.find_last_of("\\") + 1, file.length() - file.find_last_of("\\") - 5);
+        file = file.substr(file.find_last_of("\\/") + 1); // npos + 1 == 0
+        file = file.substr(0, file.find_last_of('.'));
 
-        // Initialize
-        Exporter* ex = new Exporter();
-        FbxScene* gScene = FbxScene::Create(ex->GetFbxManager(), file.c_str());
+        // Initialize. Both go away on every way out, the exporter throws on files it can't follow.
+        // The scene is declared last so it is destroyed before the manager that owns it.
+        auto destroy_scene = [](FbxScene* scene) { scene->Destroy(); };
+        std::unique_ptr<Exporter> ex = std::make_unique<Exporter>();
+        std::unique_ptr<FbxScene, decltype(destroy_scene)> gScene{ FbxScene::Create(ex->GetFbxManager(), file.c_str()), destroy_scene };
 
         // Create and save fbx
         ex->SetAssets(asset);
         ex->SetTexPath(texpath);
         ex->SetOutPath(outpath);
-        ex->CreateScene(gScene);
-        ex->SaveScene(ex->GetFbxManager(), gScene, file.c_str(), 0);
 
-        // De-allocate memory
-        gScene->Destroy();
-        delete ex; // automatically calls the destructor
+        auto start = std::chrono::steady_clock::now();
+        FbxScene* scene = gScene.get();
+        if (!ex->CreateScene(scene)) return false;
+        auto built = std::chrono::steady_clock::now();
+        const bool saved = ex->SaveScene(ex->GetFbxManager(), scene, file.c_str(), 0);
+
+        if (timings) {
+            timings->sceneBuild = std::chrono::duration<f64>(built - start).count();
+            timings->fileWrite = std::chrono::duration<f64>(std::chrono::steady_clock::now() - built).count();
+        }
+        return saved;
     }
 }
\ No newline at end of file
@@ -4,5 +4,14 @@
 #include "HGR/HGR.h"
 
 namespace tools {
-	void CreateFBX(hgr::assetData& asset, const char* path, const char* texpath, const char* outpath);
+	// Wall time of the two halves of CreateFBX, in seconds
+	struct fbx_timings {
+		f64		sceneBuild{};
+		f64		fileWrite{};
+	};
+
+	// Builds the scene of 'asset' and saves it as outpath/<stem of path>.fbx. Returns false if the scene
+	// can't be built or written, throws std::runtime_error on references the exporter can't follow.
+	[[nodiscard]] bool CreateFBX(const hgr::assetData& asset, const char* path, const char* texpath, const char* outpath,
+								 fbx_timings* timings = nullptr);
 }
\ No newline at end of file
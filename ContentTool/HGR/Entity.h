@@ -2,40 +2,33 @@
 #include <string.h>
 #include "../Common/PrimitiveTypes.h"
 #include "../Common/Math.h"
+#include <string>
+#include <vector>
 
 namespace tools::hgr {
-	struct node {
-		std::string				name{};
-		math::float3x4			modeltm{}; // Transform
-		u32						nodeFlags{}; // Refer to Node::NodeFlags
-		u32						id{u32_invalid_id}; // Node Class ID ?
-		u32						parentIndex{}; // -1 if no parent
-
-		std::vector<u32>		childIndex;
-		bool					isEnabled{ false };
-		u32						classID{};
-		u32						index{u32_invalid_id};
-	};
-
 	struct meshbone {
 		u32						boneNodeIndex{};
 		math::float3x4			invresttm; // BoneInverseRestTransform
 	};
 
-	struct mesh : node {
+	// Class payloads, each one refers back to its row in the node_table
+	struct mesh {
+		u32						nodeIndex{ u32_invalid_id };
 		u32						primCount{};
 		u32*					primIndex{};
 		u32						meshboneCount{};
-		meshbone*				meshbone{};
+		meshbone*				meshbones{};
 	};
 
-	struct camera : node {
+	struct camera {
+		u32				nodeIndex{ u32_invalid_id };
 		f32				front{};
 		f32				back{};
 		f32				FOV{}; // Horizon FOV in Radians
 	};
 
-	struct light : node {
+	struct light {
+		u32				nodeIndex{ u32_invalid_id };
 		math::float3	colour{};
 		f32				reserved1{};
 		f32				reserved2{};
@@ -47,7 +40,8 @@ namespace tools::hgr {
 
 	};
 
-	struct dummy : node {
+	struct dummy {
+		u32				nodeIndex{ u32_invalid_id };
 		math::float3	boxMin{};
 		math::float3	boxMax{};
 	};
@@ -62,7 +56,8 @@ namespace tools::hgr {
 		u32				endLine{};
 	};
 
-	struct shape : node {
+	struct shape {
+		u32				nodeIndex{ u32_invalid_id };
 		s32				lineCount{};
 		s32				pathCount{};
 		line*			lines{};
@@ -121,6 +116,38 @@ namespace tools::hgr {
 		NODE_DEFAULTS = NODE_ENABLED || NODE_OTHER,
 	};
 
+	// Every scene node, stored once, in file order (meshes, cameras, lights, dummies, shapes, other nodes),
+	// which is the order parent indices refer to. One array per field; the class data of node i is entry
+	// payloads[i] of the array for its section (assetData::meshInfo, cameraInfo, ...). Other nodes have none.
+	// payloadClass[i] names that section by its class. It can differ from classID(i), which is whatever
+	// the file's flags say; only payloadClass tells which array payloads[i] indexes.
+	struct node_table {
+		std::vector<std::string>		names{};
+		std::vector<math::float3x4>		modeltm{}; // Transform
+		std::vector<u32>				nodeFlags{}; // Refer to Node::NodeFlags
+		std::vector<u32>				ids{}; // Node Class ID ?
+		std::vector<u32>				parents{}; // u32_invalid_id if no parent, children are in assetData::hierarchy
+		std::vector<u32>				payloads{}; // u32_invalid_id if there is no class data
+		std::vector<u32>				payloadClass{}; // NodeClassId of the section the row was read from
+
+		[[nodiscard]] u32 size() const { return u32(names.size()); }
+
+		// Grows every column, nodes of a section can be read before the ones in front of them
+		void reserve_rows(u32 count) {
+			if (count <= size()) return;
+			names.resize(count);
+			modeltm.resize(count);
+			nodeFlags.resize(count);
+			ids.resize(count);
+			parents.resize(count, u32_invalid_id);
+			payloads.resize(count, u32_invalid_id);
+			payloadClass.resize(count, NODE_OTHER);
+		}
+
+		[[nodiscard]] u32 classID(u32 i) const { return nodeFlags[i] & NODE_CLASS; }
+		[[nodiscard]] bool isEnabled(u32 i) const { return nodeFlags[i] & NODE_ENABLED; }
+	};
+
 	enum BehaviourType
 	{
 		/** Animation loops to start after reaching end. */
@@ -0,0 +1,99 @@
+#include "Geometry.h"
+#include "HGR.h"
+#include "../Common/Arena.h"
+#include "../Common/Stats.h"
+#include "../Common/Trace.h"
+#include <cmath>
+
+namespace tools::hgr {
+
+	namespace {
+		// Splits 'verts' elements of 'dim' interleaved floats into the component arrays of one channel
+		void deinterleave(const f32* src, u32 verts, u32 dim, u32 stride, f32* const* out, u32 outDim) {
+			for (u32 k{ 0 };k < outDim;++k) {
+				f32* dst = out[k];
+				if (k < dim) {
+					for (u32 i{ 0 };i < verts;++i) dst[i] = src[i * dim + k];
+					memset(dst + verts, 0, sizeof(f32) * (stride - verts));
+				}
+				else {
+					memset(dst, 0, sizeof(f32) * stride);
+				}
+			}
+		}
+
+		// Bone indices of the normalized formats straight from their bits, as the integers the file stores:
+		// one byte per component for DF_V4_8, 5 bits for x/y/z and the top bit for w for DF_V4_5.
+		// False for the other formats, those go through VertexFormat::decode.
+		bool bone_indices(const vertArray& stream, u32 verts, f32* out) {
+			if (stream.format == VertexFormat::DF_V4_8) {
+				const u8* src = stream.as<u8>();
+				for (u32 i{ 0 };i < verts * 4;++i) out[i] = f32(src[i]);
+				return true;
+			}
+			if (stream.format == VertexFormat::DF_V4_5) {
+				const u8* src = stream.as<u8>();
+				for (u32 i{ 0 };i < verts;++i) {
+					const u16 bits = u16(src[i * 2] | (src[i * 2 + 1] << 8)); // little-endian
+					*out++ = f32(bits & 31);
+					*out++ = f32((bits >> 5) & 31);
+					*out++ = f32((bits >> 10) & 31);
+					*out++ = f32(bits >> 15);
+				}
+				return true;
+			}
+			return false;
+		}
+	}
+
+	bool build_geometry(std::vector<primitive_info>& prims, Arena& arena) {
+		using geometry = primitive_geometry;
+		stats::scoped_timer timer{ stats::TIMER_VERTEX_DECODE };
+		trace::zone zone{ "vertex_decode" };
+
+		bool ok{ true };
+		std::vector<f32> decoded; // one stream, interleaved, reused for every stream
+		for (primitive_info& p : prims) {
+			geometry& g = p.geometry;
+			g = {};
+			g.verts = p.verts;
+			g.stride = (p.verts + 3) & ~3u;
+
+			// One allocation for all channels of the primitive
+			u32 components{ 0 };
+			for (u32 c{ 0 };c < geometry::CHANNEL_COUNT;++c) {
+				if (p.layout.has(geometry::CHANNEL_TYPE[c])) components += geometry::CHANNEL_DIM[c];
+			}
+			if (!components || !g.stride) continue;
+
+			static_assert(geometry::ALIGNMENT % sizeof(f32) == 0 && (geometry::ALIGNMENT / sizeof(f32)) == 4);
+			f32* block = static_cast<f32*>(arena.allocate(sizeof(f32) * size_t(g.stride) * components, geometry::ALIGNMENT));
+
+			for (u32 c{ 0 };c < geometry::CHANNEL_COUNT;++c) {
+				const VertexFormat::DataType dt = geometry::CHANNEL_TYPE[c];
+				if (!p.layout.has(dt)) continue;
+
+				const u32 dim = geometry::CHANNEL_DIM[c];
+				for (u32 k{ 0 };k < dim;++k) {
+					g.data[c][k] = block;
+					block += g.stride;
+				}
+
+				const vertArray& stream = p.vArray[p.layout.stream[dt]];
+				const VertexFormat::FormatDesc& desc = VertexFormat::getDesc(stream.format);
+				decoded.resize(size_t(p.verts) * desc.dim);
+				const bool bits = c == geometry::BONEINDICES && bone_indices(stream, p.verts, decoded.data());
+				if (!bits && !VertexFormat::decode(stream.format, stream.value, p.verts, stream.scale, stream.bias, decoded.data())) {
+					ok = false;
+					decoded.assign(decoded.size(), 0.f);
+				}
+				else if (!bits && c == geometry::BONEINDICES) {
+					for (f32& v : decoded) v = std::nearbyint(v);
+				}
+
+				deinterleave(decoded.data(), p.verts, desc.dim, g.stride, g.data[c], dim);
+			}
+		}
+		return ok;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "HGRCommon.h"
+#include <vector>
+
+namespace tools { class Arena; }
+
+namespace tools::hgr {
+
+	struct primitive_info;
+
+	// Vertex data of one primitive decoded once, right after parsing, into one float array per component
+	// (structure of arrays). Every array starts on a 16-byte boundary and is zero-padded to 'stride' vertices,
+	// a multiple of 4, so SIMD loops can run over whole vectors without a tail.
+	// Channels the primitive doesn't have are null; components a stream doesn't have are zero.
+	struct primitive_geometry {
+		enum Channel {
+			POSITION,
+			NORMAL,
+			UV0,
+			UV1,
+			COLOR, // diffuse
+			BONEWEIGHTS,
+			BONEINDICES, // whole numbers, not normalized
+			CHANNEL_COUNT
+		};
+
+		static constexpr u32 ALIGNMENT{ 16 };
+		static constexpr u32 MAX_DIM{ 4 };
+		static constexpr u8 CHANNEL_DIM[CHANNEL_COUNT]{ 3, 3, 2, 2, 4, 4, 4 };
+		static constexpr VertexFormat::DataType CHANNEL_TYPE[CHANNEL_COUNT]{
+			VertexFormat::DT_POSITION, VertexFormat::DT_NORMAL, VertexFormat::DT_TEX0, VertexFormat::DT_TEX1,
+			VertexFormat::DT_DIFFUSE, VertexFormat::DT_BONEWEIGHTS, VertexFormat::DT_BONEINDICES
+		};
+
+		u32				verts{};
+		u32				stride{}; // verts rounded up to a multiple of 4
+		f32*			data[CHANNEL_COUNT][MAX_DIM]{}; // owned by the parse arena
+
+		[[nodiscard]] bool has(Channel c) const { return data[c][0] != nullptr; }
+
+		// Component k (x, y, z, w / u, v / r, g, b, a) of channel c, 'stride' floats long
+		[[nodiscard]] const f32* get(Channel c, u32 k) const { return data[c][k]; }
+	};
+
+	// Decodes the streams of every primitive into its geometry, allocating from arena.
+	// Returns false if a stream has a format that can't be decoded.
+	bool build_geometry(std::vector<primitive_info>& prims, Arena& arena);
+}
@@ -1,12 +1,21 @@
 #include <iostream>
-#include <fstream>
 #include <filesystem>
-#include <Windows.h>
 
 #include "HGR.h"
 #include "../ToolCommon.h"
+#include "../Common/Arena.h"
+#include "../Common/Dequantize.h"
+#include "../Common/MappedFile.h"
+#include "../Common/Parallel.h"
+#include "../Common/Stats.h"
+#include "../Common/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <string_view>
 #include "Entity.h"
+#if TOOLS_WITH_FBX
 #include "../FBXExporter.h"
+#endif
 
 namespace tools::hgr {
 
@@ -14,17 +23,29 @@ namespace tools::hgr {
         constexpr u32 su16{ sizeof(u16) }; // 2 bytes for reading
         constexpr u32 su32{ sizeof(u32) }; // 4 bytes for reading
 
-        u16 version{ 0 };
-        bool corrupt{ false };
-        std::vector<node> entityNodes;
-        entity_info entityInfo{};
+        // Everything a single parse has to carry around. StoreData owns one per call, so
+        // several files can be parsed at the same time on different threads.
+        struct parse_context {
+            u16                     version{ 0 };
+            bool                    corrupt{ false };
+            entity_info             entityInfo{};
+            Arena*                  arena{ nullptr }; // owns everything the readers allocate, not needed to index
+            const u8*               end{ nullptr }; // the readers that take the context stop here
+            u64                     vertexCount{ 0 }; // totals over all primitives, only the index pass fills these
+            u64                     indexCount{ 0 };
+        };
 
         constexpr bool is_big_endian = (std::endian::native == std::endian::big);
 
-        bool check_signature(const u8*& at) {
+        // True if 'bytes' more can be read at 'at' without passing 'end'. Sizes are u64, so the ones
+        // worked out from counts in the file can't wrap around.
+        bool fits(const u8* at, const u8* end, u64 bytes) {
+            return at <= end && bytes <= u64(end - at);
+        }
+
+        bool check_signature(const u8*& at, hgr_info& info) {
             // Check Signature
-            char magic[5]; memcpy(magic, at, 5);
-            std::string str = "hgrf";
+            memcpy(info.m_signature, at, 5);
             //int z = memcmp(magic, "hgrfi", 4);
             //if (magic != str.c_str()) return false; // Fails to check RN
             at += 5;
@@ -38,15 +59,29 @@ namespace tools::hgr {
             //info.check_id = swap_endian<u32>(info.check_id);
             SWAP(info.check_id, u32);
 
-            assert(info.check_id == id && "Check ID Failed");
-            return true;
+            return info.check_id == id; // otherwise the section before it had the wrong size
+        }
+
+        // Hands out a pointer straight into the mapped file when it is suitably aligned for T,
+        // otherwise falls back to a copy in the arena.
+        template<typename T>
+        const T* view_or_copy(const u8* at, u32 count, u32 bytes, Arena& arena) {
+            if (reinterpret_cast<uintptr_t>(at) % alignof(T) == 0) {
+                return reinterpret_cast<const T*>(at);
+            }
+
+            T* copy = arena.create_array<T>(count);
+            memcpy(copy, at, bytes);
+            return copy;
         }
 
         bool read_buffer(const u8*& at, hgr_info& info) {
             memcpy(&(info.m_ver), at, 1); at += 1;
-            if (info.m_ver > 190) memcpy(&(info.m_exportedVer), at, su32); at += su32; // Currently reading little Endian
+            // Both fields are there in every version, they only mean something from 191 / 181 on.
+            // They are kept either way so the writer can put them back.
+            memcpy(&(info.m_exportedVer), at, su32); at += su32; // Currently reading little Endian
             memcpy(&(info.m_dataFlags), at, su16); at += su16;
-            if (info.m_ver > 180) memcpy(&(info.m_platformID), at, su16); at += su16;
+            memcpy(&(info.m_platformID), at, su16); at += su16;
 
             return true;
         }
@@ -75,7 +110,7 @@ namespace tools::hgr {
             return true;
         }
 
-        bool read_buffer(const u8*& at, texParam*& info, u8& count) {
+        bool read_buffer(const u8*& at, parse_context& ctx, texParam*& info, u8& count) {
             u16 size{ 0 };
             for (int i{ 0 };i < count;++i) {
                 memcpy(&size, at, su16); at += su16;
@@ -84,22 +119,19 @@ namespace tools::hgr {
 
                 memcpy(&(info[i].texIndex), at, su16); at += su16;
                 SWAP(info[i].texIndex, u16);
-                if (info[i].texIndex > entityInfo.Texture_Count) {
-                    assert(info[i].texIndex > entityInfo.Texture_Count);
-                    return false;
-                }
+                if (info[i].texIndex >= ctx.entityInfo.Texture_Count) return false; // the exporter looks it up in texInfo
             }
             return true;
         }
 
-        bool read_buffer(const u8*& at, vec4Param*& info, u8& count) {
+        bool read_buffer(const u8*& at, parse_context& ctx, vec4Param*& info, u8& count) {
             u16 size{ 0 };
             for (int i{ 0 };i < count;++i) {
                 memcpy(&size, at, su16); at += su16;
                 SWAP(size, u16);
                 info[i].param_type.assign(at, at + size); at += size; // param Type
 
-                if (corrupt) { // error case
+                if (ctx.corrupt) { // error case
                     if (info[i].param_type == "AM>9ENTC") {
                         info[i].param_type = "AMBIENTC";
                     }
@@ -134,7 +166,25 @@ namespace tools::hgr {
             return true;
         }
 
-        bool read_buffer(const u8*& at, std::vector<material_info>& info, u32& count) {
+        // Some corrupt levels store a length of 249 for a 9 character shader name
+        bool read_shader_name(const u8*& at, const parse_context& ctx, std::string_view& name) {
+            u16 size{ 0 };
+            if (!fits(at, ctx.end, su16)) return false;
+            memcpy(&size, at, su16); at += su16;
+            SWAP(size, u16);
+            name = { reinterpret_cast<const char*>(at), std::min<size_t>(size, size_t(ctx.end - at)) };
+            if (ctx.corrupt) {
+                if (size == 249 && name.starts_with("")) {
+                    size = 9;
+                }
+            }
+            if (!fits(at, ctx.end, size)) return false;
+            name = name.substr(0, size);
+            at += size; // shaderName
+            return true;
+        }
+
+        bool read_buffer(const u8*& at, parse_context& ctx, std::vector<material_info>& info, u32& count) {
             u16 size{ 0 };
             material_info m{};
             for (u32 i{ 0 };i < count;++i) {
@@ -142,33 +192,26 @@ namespace tools::hgr {
                 SWAP(size, u16);
                 m.name.assign(at, at + size); at += size; // name
 
-                memcpy(&size, at, su16); at += su16;
-                SWAP(size, u16);
-                m.shaderName.assign(at, at + size);
-                if (corrupt) {
-                    if (size == 249 && m.shaderName.starts_with("")) {
-                        size = 9;
-                        m.shaderName.assign(at, at + size);
-                    }
-                }
-                at += size; // shaderName
+                std::string_view shaderName{};
+                if (!read_shader_name(at, ctx, shaderName)) return false;
+                m.shaderName = shaderName;
 
                 memcpy(&(m.lightmap_info), at, su32); at += su32;
                 SWAP(m.lightmap_info, s32);
 
                 memcpy(&(m.texParamCount), at, 1); at += 1;
                 SWAP(m.texParamCount, u8);
-                m.TexParams = new texParam[m.texParamCount];
-                assert(read_buffer(at, m.TexParams, m.texParamCount));
+                m.TexParams = ctx.arena->create_array<texParam>(m.texParamCount);
+                if (!read_buffer(at, ctx, m.TexParams, m.texParamCount)) return false;
 
                 memcpy(&(m.vec4ParamCount), at, 1); at += 1;
                 SWAP(m.vec4ParamCount, u8);
-                m.Vec4Params = new vec4Param[m.vec4ParamCount];
-                read_buffer(at, m.Vec4Params, m.vec4ParamCount);
+                m.Vec4Params = ctx.arena->create_array<vec4Param>(m.vec4ParamCount);
+                read_buffer(at, ctx, m.Vec4Params, m.vec4ParamCount);
 
                 memcpy(&(m.floatParamCount), at, 1); at += 1;
                 SWAP(m.floatParamCount, u8);
-                m.FloatParams = new floatParam[m.floatParamCount];
+                m.FloatParams = ctx.arena->create_array<floatParam>(m.floatParamCount);
                 read_buffer(at, m.FloatParams, m.floatParamCount);
 
                 info.emplace_back(m);
@@ -176,76 +219,93 @@ namespace tools::hgr {
             return true;
         }
 
-        bool read_buffer(const u8*& at, vertFormat*& info, u8& count) {
+        vertFormat to_vertFormat(std::string_view type, std::string_view format) {
+            return { VertexFormat::toDataType(type), VertexFormat::toDataFormat(format) };
+        }
+
+        // Names are looked at in place, the index pass runs this too and allocates nothing
+        bool read_buffer(const u8*& at, parse_context& ctx, vertFormat*& info, u8& count) {
             u16 size{ 0 };
+            std::string_view type{}, format{};
+            auto name = [&](const u8* from, u16 length, std::string_view& out) {
+                if (!fits(from, ctx.end, length)) return false;
+                out = { reinterpret_cast<const char*>(from), length };
+                return true;
+            };
+
             for (int i{ 0 };i < count;++i) {
+                if (!fits(at, ctx.end, su16)) return false;
                 memcpy(&size, at, su16); at += su16;
                 SWAP(size, u16);
-                info[i].type.assign(at, at + size); // type with "DT_" prefix
+                if (!name(at, size, type)) return false; // type with "DT_" prefix
 
-                if (corrupt) { // ERROR CASES
-                    if (info[i].type == "DT_") {
+                if (ctx.corrupt) { // ERROR CASES
+                    if (type == "DT_") {
                         size = 5;
-                        info[i].type.assign(at, at + size);
+                        if (!name(at, size, type)) return false;
                     }
-                    if (info[i].type == "DT_TE") {
+                    if (type == "DT_TE") {
                         size = 7;
-                        info[i].type.assign(at, at + size);
+                        if (!name(at, size, type)) return false;
                     }
-                    if (info[i].type == "4WEX0") {
-                        info[i].type = "DT_TEX0";
+                    if (type == "4WEX0") {
+                        type = "DT_TEX0";
                     }
-                    if (info[i].type == "DT_PO") {
+                    if (type == "DT_PO") {
                         size = 11;
-                        info[i].type.assign(at, at + size);
+                        if (!name(at, size, type)) return false;
                     }
-                    if (info[i].type == "4+POSITION") {
-                        info[i].type = "DT_POSITION";
+                    if (type == "4+POSITION") {
+                        type = "DT_POSITION";
                     }
-                    if (info[i].type == "DT_POSITIOJ") {
+                    if (type == "DT_POSITIOJ") {
                         at += size;
                         size = 5; at += su16;
-                        info[i].format.assign(at, at + size); at += size;
+                        if (!name(at, size, format)) return false;
+                        at += size;
+                        info[i] = to_vertFormat("DT_POSITION", format);
                         continue;
                     }
-                    if (info[i].type == "_PO") {
+                    if (type == "_PO") {
                         size = 11;
-                        info[i].type = "DT_POSITION";
+                        if (!fits(at, ctx.end, size)) return false;
+                        type = "DT_POSITION";
                     }
-                    if (info[i].type == "DT_TEX\x10") {
-                        info[i].type = "DT_TEX0";
+                    if (type == "DT_TEX\x10") {
+                        type = "DT_TEX0";
                     }
                 }
 
                 at += size;
 
+                if (!fits(at, ctx.end, su16)) return false;
                 memcpy(&size, at, su16); at += su16;
                 SWAP(size, u16);
-                info[i].format.assign(at, at + size); // format without "DF_" prefix
-                //info[i].format = "DF_" + info[i].format;
-                if (corrupt) { // ERROR CASES
-                    if (info[i].format == "V3_\n") {
-                        info[i].format = "V3_16";
+                if (!name(at, size, format)) return false; // format without "DF_" prefix
+                //format = "DF_" + format;
+                if (ctx.corrupt) { // ERROR CASES
+                    if (format == "V3_\n") {
+                        format = "V3_16";
                     }
-                    if (info[i].format.substr(0, 3) == "V") {
-                        info[i].format = "V2_16";
+                    if (format.substr(0, 3) == "V") {
+                        format = "V2_16";
                     }
-                    if (info[i].format == "V") {
-                        info[i].format = "V2_16";
+                    if (format == "V") {
+                        format = "V2_16";
                     }
                 }
                 at += size;
+
+                info[i] = to_vertFormat(type, format);
             }
             return true;
         }
 
-        bool read_buffer(const u8*& at, vertArray*& info, u8& count, u32 verts, vertFormat* formats) {
-            u32 size{ 0 };
-            u32 length{ 0 };
+        bool read_buffer(const u8*& at, parse_context& ctx, vertArray*& info, u8& count, u32 verts, vertFormat* formats) {
 
             f32 posscalebias[4]{ 1,0,0,0 };
             f32 uvscalebias[4]{ 1,0,0,0 };
-            if (version >= 190) {
+            if (ctx.version >= 190) {
                 // posscalebias = readFloat4();
                 memcpy(&(posscalebias), at, su32 * 4); at += su32 * 4;
                 for (int i{ 0 };i < 4;++i) SWAP(posscalebias[i], f32);
@@ -260,36 +320,35 @@ namespace tools::hgr {
                 //SWAP(info[i].scale, f32);
                 //memcpy(&(info[i].bias), at, su32 * 3); at += su32 * 3;
 
-                if (version < 190) {
+                if (ctx.version < 190) {
                     // dummy scale + bias4 -> discarded data
                     at += su32;
                     at += su32 * 4;
                 }
 
-                size = VertexFormat::getDataDim(VertexFormat::toDataFormat(formats[i].format.c_str()));
-                if (formats[i].type == "DT_POSITIOJ") {
-                    formats[i].type = "DT_POSITION";
-                }
-                assert(size > 0);
-                length = VertexFormat::getDataSize(VertexFormat::toDataFormat(formats[i].format.c_str()));
-                length /= size;
-                size *= verts;
+                const VertexFormat::FormatDesc& desc = VertexFormat::getDesc(formats[i].format);
+                assert(desc.dim > 0);
+                const u32 bytes = desc.size * verts;
 
-                info[i].value = new s16[size];
+                // Kept in the native width of the format: float streams are used in place, 8-bit ones
+                // need no alignment, 16-bit and packed ones are viewed as s16
+                info[i].format = formats[i].format;
+                if (desc.isFloat) info[i].value = view_or_copy<f32>(at, bytes / su32, bytes, *ctx.arena);
+                else if (desc.componentSize == 1) info[i].value = at;
+                else info[i].value = view_or_copy<s16>(at, bytes / su16, bytes, *ctx.arena); // Lets see with little endian
+                at += bytes;
 
-                memcpy(info[i].value, at, size * length); at += size * length; // Lets see with little endian
-                //for (u32 j{ 0 };j < size;++j) {
-                //    SWAP(info[i].value[j], s16);
-                //}
+                // Streams without a scale/bias in the file decode as they are
+                info[i].scale = 1.f;
 
                 // Copy pos and uv to respective datatype channels
-                if (VertexFormat::toDataType(formats[i].type.c_str()) == VertexFormat::DT_POSITION) {
+                if (formats[i].type == VertexFormat::DT_POSITION) {
                     info[i].scale = posscalebias[0];
                     info[i].bias[0] = posscalebias[1];
                     info[i].bias[1] = posscalebias[2];
                     info[i].bias[2] = posscalebias[3];
                 }
-                else if (VertexFormat::toDataType(formats[i].type.c_str()) == VertexFormat::DT_TEX0) {
+                else if (formats[i].type == VertexFormat::DT_TEX0) {
                     info[i].scale = uvscalebias[0];
                     info[i].bias[0] = uvscalebias[1];
                     info[i].bias[1] = uvscalebias[2];
@@ -297,27 +356,28 @@ namespace tools::hgr {
                 }
 
                 // Set Bounds of Primitive - I'm not reading rn, so i can fix this later in a different area
-                if (VertexFormat::toDataType(formats[i].type.c_str()) == VertexFormat::DT_POSITION) {
+                if (formats[i].type == VertexFormat::DT_POSITION) {
                     //math::float4 boundmin, boundmax;
                     //float boundradius;
                     //VertexFormat::getBound(&buf[0], df, verts, posscalebias, &boundmin, &boundmax, &boundradius);
                     //prim->setBound(boundmin.xyz(), boundmax.xyz(), boundradius);
                 }
 
-                info[i].size = size;
+                info[i].size = desc.dim * verts;
             }
             return true;
         }
 
         // TODO: Fix UV Mapping
-        bool read_buffer(const u8*& at, std::vector<primitive_info>& info, u32& count) {
+        bool read_buffer(const u8*& at, parse_context& ctx, std::vector<primitive_info>& info, u32& count) {
             primitive_info p{};
             for (u32 i{ 0 };i < count;++i) {
-                if (version < 190) {
-                    memcpy(&(p.verts), at, su16); at += su16;
-                    SWAP(p.verts, u32);
-                    memcpy(&(p.indices), at, su16); at += su16;
-                    SWAP(p.indices, u32);
+                if (ctx.version < 190) { // 16-bit counts
+                    u16 count16{ 0 };
+                    memcpy(&count16, at, su16); at += su16;
+                    p.verts = swap_endian<u16>(count16);
+                    memcpy(&count16, at, su16); at += su16;
+                    p.indices = swap_endian<u16>(count16);
                 }
                 else {
                     memcpy(&(p.verts), at, su32); at += su32;
@@ -327,12 +387,17 @@ namespace tools::hgr {
                 }
 
                 memcpy(&(p.formatCount), at, 1); at += 1;
-                p.formats = new vertFormat[p.formatCount];
-                p.vArray = new vertArray[p.formatCount];
+                p.formats = ctx.arena->create_array<vertFormat>(p.formatCount);
+                p.vArray = ctx.arena->create_array<vertArray>(p.formatCount);
+
+                read_buffer(at, ctx, p.formats, p.formatCount);
 
-                read_buffer(at, p.formats, p.formatCount);
+                p.layout = {};
+                for (u8 j{ 0 };j < p.formatCount;++j) {
+                    if (p.formats[j].type < VertexFormat::DT_SIZE) p.layout.stream[p.formats[j].type] = j;
+                }
 
-                if (p.verts == 24 && p.indices == 162 && corrupt) { // Error Case
+                if (p.verts == 24 && p.indices == 162 && ctx.corrupt) { // Error Case
                     p.verts = 56;
                 }
 
@@ -341,26 +406,31 @@ namespace tools::hgr {
                 memcpy(&(p.primitiveType), at, su16); at += su16; // Primitive::PRIM_TRI -> Default
                 SWAP(p.primitiveType, u16);
 
-                read_buffer(at, p.vArray, p.formatCount, p.verts, p.formats);
+                read_buffer(at, ctx, p.vArray, p.formatCount, p.verts, p.formats);
 
                 // WARNING: Endianess dependent read
-                p.indexData = new u16[p.indices];
-                memcpy(p.indexData, at, su16 * p.indices); at += su16 * p.indices;
                 //for (u32 j{ 0 };j < p.indices;++j) {
                 //    SWAP(p.indexData[j], u16);
                 //}
-                if (corrupt) { // Error Case
+                if (ctx.corrupt) { // Error Case -> the indices get patched, so they need their own copy
+                    u16* indexData = ctx.arena->create_array<u16>(p.indices);
+                    memcpy(indexData, at, su16 * p.indices);
                     for (u32 j{ 0 };j < p.indices;++j) {
-                        if (p.indexData[j] > p.verts) {
-                            p.indexData[j] = (u16)p.verts - 1;
+                        if (indexData[j] >= p.verts) {
+                            indexData[j] = (u16)p.verts - 1;
                         }
                     }
+                    p.indexData = indexData;
+                }
+                else {
+                    p.indexData = view_or_copy<u16>(at, p.indices, su16 * p.indices, *ctx.arena);
                 }
+                at += su16 * p.indices;
 
                 memcpy(&(p.usedBoneCount), at, 1); at += 1;
                 assert(p.usedBoneCount <= MAX_BONES && ("Failed to load scene. Too many bones: " + i));
 
-                p.usedBones = new u8[p.usedBoneCount];
+                p.usedBones = ctx.arena->create_array<u8>(p.usedBoneCount);
                 memcpy(p.usedBones, at, p.usedBoneCount); at += p.usedBoneCount;
 
                 info.emplace_back(p);
@@ -368,34 +438,33 @@ namespace tools::hgr {
             return true;
         }
 
-        bool read_buffer(const u8*& at, node& info) {
-            u16 size{ 0 }; u32 i{ 0 };
+        // Reads one node header straight into row i of the table
+        bool read_buffer(const u8*& at, node_table& nodes, u32 i) {
+            u16 size{ 0 };
             memcpy(&size, at, su16); at += su16;
             SWAP(size, u16);
-            info.name.assign(at, at + size); at += size; // name
-
-            for (i = 0;i < 3;++i) { // 3 rows 4 columns
-                memcpy(&info.modeltm.x[i], at, su32); at += su32; // Pos
-                memcpy(&info.modeltm.y[i], at, su32); at += su32;
-                memcpy(&info.modeltm.z[i], at, su32); at += su32;
-                memcpy(&info.modeltm.w[i], at, su32); at += su32;
-                SWAP(info.modeltm.x[i], f32);
-                SWAP(info.modeltm.y[i], f32);
-                SWAP(info.modeltm.z[i], f32);
-                SWAP(info.modeltm.w[i], f32);
+            nodes.names[i].assign(at, at + size); at += size; // name
+
+            math::float3x4& modeltm = nodes.modeltm[i];
+            for (u32 j{ 0 };j < 3;++j) { // 3 rows 4 columns
+                memcpy(&modeltm.x[j], at, su32); at += su32; // Pos
+                memcpy(&modeltm.y[j], at, su32); at += su32;
+                memcpy(&modeltm.z[j], at, su32); at += su32;
+                memcpy(&modeltm.w[j], at, su32); at += su32;
+                SWAP(modeltm.x[j], f32);
+                SWAP(modeltm.y[j], f32);
+                SWAP(modeltm.z[j], f32);
+                SWAP(modeltm.w[j], f32);
             }
 
-            memcpy(&(info.nodeFlags), at, su32); at += su32;
-            SWAP(info.nodeFlags, u32);
+            memcpy(&(nodes.nodeFlags[i]), at, su32); at += su32;
+            SWAP(nodes.nodeFlags[i], u32);
 
-            memcpy(&(info.id), at, su32); at += su32;
-            SWAP(info.id, u32);
+            memcpy(&(nodes.ids[i]), at, su32); at += su32;
+            SWAP(nodes.ids[i], u32);
 
-            memcpy(&(info.parentIndex), at, su32); at += su32; // u32_invalid_id = -1 -> iron-blooded orphan
-            SWAP(info.parentIndex, u32);
-
-            info.isEnabled = NODE_ENABLED & info.nodeFlags;
-            info.classID = (NODE_CLASS & info.nodeFlags);
+            memcpy(&(nodes.parents[i]), at, su32); at += su32; // u32_invalid_id = -1 -> iron-blooded orphan
+            SWAP(nodes.parents[i], u32);
 
             return true;
         }
@@ -421,31 +490,20 @@ namespace tools::hgr {
             return true;
         }
 
-        [[nodiscard]]
-        std::vector<node> read_buffer(const u8*& at, mesh*& info, u32& count) {
-            u32 j{ 0 }; node x;
-            entityNodes.clear();
+        bool read_buffer(const u8*& at, Arena& arena, node_table& nodes, u32 first, mesh*& info, u32& count) {
+            u32 j{ 0 };
 
             for (u32 i{ 0 };i < count;++i) {
-                read_buffer(at, x);
-                // Assign Node Values
-                info[i].name = x.name;
-                info[i].modeltm = x.modeltm;
-                info[i].nodeFlags = x.nodeFlags;
-                info[i].id = x.id;
-                info[i].parentIndex = x.parentIndex;
-                info[i].childIndex = x.childIndex;
-                info[i].isEnabled = x.isEnabled;
-                info[i].classID = x.classID;
-
-                info[i].index = i;
-                entityNodes.push_back({ info[i].name, info[i].modeltm, info[i].nodeFlags, info[i].id, info[i].parentIndex, info[i].childIndex, info[i].isEnabled, info[i].classID, info[i].index });
+                read_buffer(at, nodes, first + i);
+                nodes.payloads[first + i] = i;
+                nodes.payloadClass[first + i] = NODE_MESH;
+                info[i].nodeIndex = first + i;
 
                 memcpy(&(info[i].primCount), at, su32); at += su32;
                 SWAP(info[i].primCount, u32);
 
                 if (info[i].primCount > 0) {
-                    info[i].primIndex = new u32[info[i].primCount];
+                    info[i].primIndex = arena.create_array<u32>(info[i].primCount);
                     memcpy(info[i].primIndex, at, su32 * info[i].primCount); at += su32 * info[i].primCount;
                     for (j = 0;j < info[i].primCount;++j) {
                         SWAP(info[i].primIndex[j], u32);
@@ -456,35 +514,22 @@ namespace tools::hgr {
                 SWAP(info[i].meshboneCount, u32);
 
                 if (info[i].meshboneCount > 0) {
-                    info[i].meshbone = new meshbone[info[i].meshboneCount];
+                    info[i].meshbones = arena.create_array<meshbone>(info[i].meshboneCount);
                     for (j = 0;j < info[i].meshboneCount;++j) {
-                        read_buffer(at, info[i].meshbone[j]);
+                        read_buffer(at, info[i].meshbones[j]);
                     }
                 }
             }
 
-            return entityNodes;
+            return true;
         }
 
-        [[nodiscard]]
-        std::vector<node> read_buffer(const u8*& at, camera*& info, u32& count) {
-            node x;
-            entityNodes.clear();
-
+        bool read_buffer(const u8*& at, node_table& nodes, u32 first, camera*& info, u32& count) {
             for (u32 i{ 0 };i < count;++i) {
-                read_buffer(at, x);
-                // Assign Node Values
-                info[i].name = x.name;
-                info[i].modeltm = x.modeltm;
-                info[i].nodeFlags = x.nodeFlags;
-                info[i].id = x.id;
-                info[i].parentIndex = x.parentIndex;
-                info[i].childIndex = x.childIndex;
-                info[i].isEnabled = x.isEnabled;
-                info[i].classID = x.classID;
-
-                info[i].index = i;
-                entityNodes.push_back({ info[i].name, info[i].modeltm, info[i].nodeFlags, info[i].id, info[i].parentIndex, info[i].childIndex, info[i].isEnabled, info[i].classID, info[i].index });
+                read_buffer(at, nodes, first + i);
+                nodes.payloads[first + i] = i;
+                nodes.payloadClass[first + i] = NODE_CAMERA;
+                info[i].nodeIndex = first + i;
 
                 memcpy(&(info[i].front), at, su32); at += su32;
                 SWAP(info[i].front, f32);
@@ -493,27 +538,15 @@ namespace tools::hgr {
                 memcpy(&(info[i].FOV), at, su32); at += su32;
                 SWAP(info[i].FOV, f32);
             }
-            return entityNodes;
+            return true;
         }
 
-        [[nodiscard]]
-        std::vector<node> read_buffer(const u8*& at, light*& info, u32& count) {
-            node x;
-            entityNodes.clear();
+        bool read_buffer(const u8*& at, node_table& nodes, u32 first, light*& info, u32& count) {
             for (u32 i{ 0 };i < count;++i) {
-                read_buffer(at, x);
-                // Assign Node Values
-                info[i].name = x.name;
-                info[i].modeltm = x.modeltm;
-                info[i].nodeFlags = x.nodeFlags;
-                info[i].id = x.id;
-                info[i].parentIndex = x.parentIndex;
-                info[i].childIndex = x.childIndex;
-                info[i].isEnabled = x.isEnabled;
-                info[i].classID = x.classID;
-
-                info[i].index = i;
-                entityNodes.push_back({ info[i].name, info[i].modeltm, info[i].nodeFlags, info[i].id, info[i].parentIndex, info[i].childIndex, info[i].isEnabled, info[i].classID, info[i].index });
+                read_buffer(at, nodes, first + i);
+                nodes.payloads[first + i] = i;
+                nodes.payloadClass[first + i] = NODE_LIGHT;
+                info[i].nodeIndex = first + i;
 
                 memcpy(&info[i].colour.x, at, su32 * 3); at += su32 * 3;
                 for (u32 j = 0;j < 3;++j) {
@@ -535,28 +568,16 @@ namespace tools::hgr {
                 memcpy(&(info[i].type), at, 1); at += 1;
                 SWAP(info[i].type, u8);
             }
-            return entityNodes;
+            return true;
         }
 
-        [[nodiscard]]
-        std::vector<node> read_buffer(const u8*& at, dummy*& info, u32& count) {
+        bool read_buffer(const u8*& at, node_table& nodes, u32 first, dummy*& info, u32& count) {
             u32 j{ 0 };
-            node x;
-            entityNodes.clear();
             for (u32 i{ 0 };i < count;++i) {
-                read_buffer(at, x);
-                // Assign Node Values
-                info[i].name = x.name;
-                info[i].modeltm = x.modeltm;
-                info[i].nodeFlags = x.nodeFlags;
-                info[i].id = x.id;
-                info[i].parentIndex = x.parentIndex;
-                info[i].childIndex = x.childIndex;
-                info[i].isEnabled = x.isEnabled;
-                info[i].classID = x.classID;
-
-                info[i].index = i;
-                entityNodes.push_back({ info[i].name, info[i].modeltm, info[i].nodeFlags, info[i].id, info[i].parentIndex, info[i].childIndex, info[i].isEnabled, info[i].classID, info[i].index });
+                read_buffer(at, nodes, first + i);
+                nodes.payloads[first + i] = i;
+                nodes.payloadClass[first + i] = NODE_DUMMY;
+                info[i].nodeIndex = first + i;
 
                 memcpy(&(info[i].boxMin.x), at, su32 * 3); at += su32 * 3;
                 for (j = 0;j < 3;++j) {
@@ -567,7 +588,7 @@ namespace tools::hgr {
                     SWAP(info[i].boxMax.x[j], f32);
                 }
             }
-            return entityNodes;
+            return true;
         }
 
         bool read_buffer(const u8*& at, line& info) {
@@ -594,33 +615,21 @@ namespace tools::hgr {
             return true;
         }
 
-        [[nodiscard]]
-        std::vector<node> read_buffer(const u8*& at, shape*& info, u32& count) {
-            node x;
-            entityNodes.clear();
+        bool read_buffer(const u8*& at, Arena& arena, node_table& nodes, u32 first, shape*& info, u32& count) {
             s32 j{ 0 };
             for (u32 i{ 0 };i < count;++i) {
-                read_buffer(at, x);
-                // Assign Node Values
-                info[i].name = x.name;
-                info[i].modeltm = x.modeltm;
-                info[i].nodeFlags = x.nodeFlags;
-                info[i].id = x.id;
-                info[i].parentIndex = x.parentIndex;
-                info[i].childIndex = x.childIndex;
-                info[i].isEnabled = x.isEnabled;
-                info[i].classID = x.classID;
-
-                info[i].index = i;
-                entityNodes.push_back({ info[i].name, info[i].modeltm, info[i].nodeFlags, info[i].id, info[i].parentIndex, info[i].childIndex, info[i].isEnabled, info[i].classID, info[i].index });
+                read_buffer(at, nodes, first + i);
+                nodes.payloads[first + i] = i;
+                nodes.payloadClass[first + i] = NODE_LINES;
+                info[i].nodeIndex = first + i;
 
                 memcpy(&(info[i].lineCount), at, su32); at += su32;
                 SWAP(info[i].lineCount, s32);
                 memcpy(&(info[i].pathCount), at, su32); at += su32;
                 SWAP(info[i].pathCount, s32);
 
-                info[i].lines = new line[info[i].lineCount];
-                info[i].paths = new path[info[i].pathCount];
+                info[i].lines = arena.create_array<line>(info[i].lineCount);
+                info[i].paths = arena.create_array<path>(info[i].pathCount);
 
                 for (j = 0;j < info[i].lineCount;j++) {
                     read_buffer(at, info[i].lines[j]);
@@ -629,7 +638,7 @@ namespace tools::hgr {
                     read_buffer(at, info[i].paths[j]);
                 }
             }
-            return entityNodes;
+            return true;
         }
 
         tools::math::float4 readFloat4(const u8*& at) {
@@ -650,64 +659,27 @@ namespace tools::hgr {
             return obj;
         }
 
+        static_assert(sizeof(tools::math::float4) == sizeof(f32) * 4, "keys are decoded straight into float4 arrays");
+
+        // Tracks of more than 2 keys are quantized: min and max, then 'count' u16 keys that get
+        // unpacked in one go. Shorter tracks are stored as plain floats.
+        // The range goes to 'lo' and 'hi', for the writer.
         std::vector<tools::math::float4> 
-        read_Float4Array16(const u8*& at, s32 count) {
+        read_Float4Array16(const u8*& at, s32 count, f32 (&lo)[4], f32 (&hi)[4]) {
 
-            std::vector<tools::math::float4> out;
-            out.reserve(count);
+            std::vector<tools::math::float4> out(count > 0 ? count : 0);
 
             if (count > 2) {
                 tools::math::float4 minv = readFloat4(at);
                 tools::math::float4 maxv = readFloat4(at);
 
-                tools::math::float4 delta;
-                delta.x = maxv.x - minv.x;
-                delta.y = maxv.y - minv.y;
-                delta.z = maxv.z - minv.z;
-                delta.w = maxv.w - minv.w;
-
-                tools::math::float4 zeta;
-                for (int i = 0; i < count; ++i)
-                {
-                    u16 xi; float x;
-
-                    // x
-                    memcpy(&xi, at, su16); at += su16;
-
-                    x = float(xi) * (1.f / 65535.f);
-                    x *= delta.x;
-                    x += minv.x;
-                    zeta.x = x;
-
-                    // y
-                    memcpy(&xi, at, su16); at += su16;
-
-                    x = float(xi) * (1.f / 65535.f);
-                    x *= delta.y;
-                    x += minv.y;
-                    zeta.y = x;
-
-                    // z
-                    memcpy(&xi, at, su16); at += su16;
-
-                    x = float(xi) * (1.f / 65535.f);
-                    x *= delta.z;
-                    x += minv.z;
-                    zeta.z = x;
-
-                    // w
-                    memcpy(&xi, at, su16); at += su16;
-
-                    x = float(xi) * (1.f / 65535.f);
-                    x *= delta.w;
-                    x += minv.w;
-                    zeta.w = x;
-
-                    out.emplace_back(zeta);
-                }
+                lo[0] = minv.x; lo[1] = minv.y; lo[2] = minv.z; lo[3] = minv.w;
+                hi[0] = maxv.x; hi[1] = maxv.y; hi[2] = maxv.z; hi[3] = maxv.w;
+                dequantize_u16_keys(at, count, 4, lo, hi, reinterpret_cast<f32*>(out.data()));
+                at += su16 * 4 * count;
             } else {
                 for (int i = 0; i < count; ++i)
-                    out.emplace_back(readFloat4(at));
+                    out[i] = readFloat4(at);
             }
 
             return out;
@@ -728,44 +700,28 @@ namespace tools::hgr {
             return obj;
         }
 
+        // Same as read_Float4Array16 with 3 components per key, w is left at 0
         std::vector<tools::math::float4> 
-        read_Float3Array16(const u8*& at, s32 count) {
+        read_Float3Array16(const u8*& at, s32 count, f32 (&lo)[4], f32 (&hi)[4]) {
 
-            std::vector<tools::math::float4> out;
-            out.reserve(count);
+            std::vector<tools::math::float4> out(count > 0 ? count : 0);
 
             if (count > 2)
             {
                 tools::math::float3 minv = readFloat3(at);
                 tools::math::float3 maxv = readFloat3(at);
 
-                tools::math::float3 delta{};
-                for (int k = 0; k < 3; ++k)
-                    delta.x[k] = maxv.x[k] - minv.x[k];
-
-                tools::math::float4 gamma{};
-                tools::math::float3 zeta{};
-                for (int i = 0; i < count; ++i)
-                {
-                    for (int k = 0; k < 3; ++k)
-                    {
-                        u16 xi;
-                        memcpy(&xi, at, su16); at += su16;
-                        float x = float(xi) * (1.f / 65535.f);
-                        x *= delta.x[k];
-                        x += minv.x[k];
-                        zeta.x[k] = x;
-                    }
-                    gamma = zeta;
-                    out.emplace_back(gamma);
-                }
+                memcpy(lo, minv.x, su32 * 3);
+                memcpy(hi, maxv.x, su32 * 3);
+                dequantize_u16_keys(at, count, 3, lo, hi, reinterpret_cast<f32*>(out.data()));
+                at += su16 * 3 * count;
             }
             else
             {
-                tools::math::float4 gamma{};
-                for (int i = 0; i < count; ++i)
-                    gamma = readFloat3(at);
-                    out.emplace_back(gamma);
+                for (int i = 0; i < count; ++i) {
+                    tools::math::float3 key = readFloat3(at);
+                    out[i] = tools::math::float4(key);
+                }
             }
 
             return out;
@@ -774,21 +730,21 @@ namespace tools::hgr {
         bool read_float3anim(const u8*& at, float3Animation& info) {
             memcpy(&(info.keyCount), at, su32); at += su32; info.keyCount = swap_endian<s32>(info.keyCount);
 
-            info.keys = read_Float4Array16(at, info.keyCount);
+            info.keys = read_Float4Array16(at, info.keyCount, info.minv, info.maxv);
+            if (info.keyCount > 0) stats::add(stats::COUNTER_KEYS, u64(info.keyCount));
 
             return true;
         }
 
-        bool read_buffer(const u8*& at, keyframeSequence& info) {
+        bool read_buffer(const u8*& at, parse_context& ctx, keyframeSequence& info) {
             u16 s{ 0 };
             u32 size{ 0 };
-            u32 length{ 0 };
 
             memcpy(&(info.keyCount), at, su32); at += su32; info.keyCount = swap_endian<s32>(info.keyCount);
 
-            if (version < 192) {
+            if (ctx.version < 192) {
                 memcpy(&s, at, su16); at += su16; s = swap_endian<u16>(s);
-                info.dataFormat.assign(at, at + s); at += s; // format without "DF_" prefix
+                info.dataFormat = VertexFormat::toDataFormat(std::string_view(reinterpret_cast<const char*>(at), s)); at += s; // format without "DF_" prefix
 
                 memcpy(&(info.scale), at, su32); at += su32;
                 info.scale = swap_endian<f32>(info.scale);
@@ -798,49 +754,51 @@ namespace tools::hgr {
                     info.bias[j] = swap_endian<f32>(info.bias[j]);
                 }
 
-                size = VertexFormat::getDataDim(VertexFormat::toDataFormat(info.dataFormat.c_str()));
-                length = VertexFormat::getDataSize(VertexFormat::toDataFormat(info.dataFormat.c_str()));
-                length /= size;
-                size *= info.keyCount;
-
-                f32* keys = new f32[size];
-                tools::math::float4 zeta{};
-
-                memcpy(keys, at, size * length); at += size * length;
-                for (u32 j{ 0 };j < size * length;++j) {
-                    zeta.x = swap_endian<f32>(keys[j++]);
-                    zeta.y = swap_endian<f32>(keys[j++]);
-                    if(length>2) zeta.z = swap_endian<f32>(keys[j++]);
-                    if(length>3) zeta.w = swap_endian<f32>(keys[j]);
-
-                    info.keys.emplace_back(zeta); // is it supposed to be little or big endian?
+                const VertexFormat::FormatDesc& desc = VertexFormat::getDesc(info.dataFormat);
+                assert(desc.isFloat && "Keyframe sequences are expected in a 32-bit float format");
+                size = desc.dim * info.keyCount;
+
+                // Big-endian floats, 'dim' per key, the components a format doesn't have stay 0
+                info.keys.resize(info.keyCount > 0 ? info.keyCount : 0);
+                if (desc.isFloat) {
+                    for (s32 j{ 0 };j < info.keyCount;++j) {
+                        f32 zeta[4]{};
+                        for (u32 k{ 0 };k < desc.dim;++k) {
+                            memcpy(&zeta[k], at, su32); at += su32;
+                            zeta[k] = swap_endian<f32>(zeta[k]);
+                        }
+                        info.keys[j] = tools::math::float4(zeta[0], zeta[1], zeta[2], zeta[3]);
+                    }
+                }
+                else if (info.keyCount > 0) {
+                    at += desc.size * info.keyCount; // keep the rest of the file in step
                 }
-                delete[] keys;
                 info.size = size;
             }
             else { // Implement in v193
                 int dim;
                 memcpy(&dim, at, su32); at += su32; dim = swap_endian<u32>(dim);
-                assert((dim == 4 || dim == 3) && "Keyframe sequence in {0} dimension invalid ({1})");
+                if (dim != 4 && dim != 3) return false; // the index has turned the file down already
 
                 if (dim == 4) { // VertexFormat::DF_V4_32
-                    info.dataFormat = "DF_V4_32"; // float32[4]
+                    info.dataFormat = VertexFormat::DF_V4_32; // float32[4]
                     //obj = new KeyframeSequence(keys, VertexFormat::DF_V4_32);
                     //readFloat4Array16((float4*)obj->data(), keys);
-                    info.keys = read_Float4Array16(at, info.keyCount); // Maybe Quaternion
+                    info.keys = read_Float4Array16(at, info.keyCount, info.minv, info.maxv); // Maybe Quaternion
                 }
                 else {
-                    info.dataFormat = "DF_V3_32"; // float32[3]
+                    info.dataFormat = VertexFormat::DF_V3_32; // float32[3]
                     //obj = new KeyframeSequence(keys, VertexFormat::DF_V3_32);
                     //readFloat3Array16((float3*)obj->data(), keys);
-                    info.keys = read_Float3Array16(at, info.keyCount);
+                    info.keys = read_Float3Array16(at, info.keyCount, info.minv, info.maxv);
                 }
             }
+            if (info.keyCount > 0) stats::add(stats::COUNTER_KEYS, u64(info.keyCount));
 
             return true;
         }
 
-        bool read_buffer(const u8*& at, transformAnimation*& info, u32& count) {
+        bool read_buffer(const u8*& at, parse_context& ctx, transformAnimation*& info, u32& count) {
             u16 size{ 0 };
             for (u32 i{ 0 };i < count;++i) {
                 memcpy(&size, at, su16); at += su16;
@@ -855,30 +813,30 @@ namespace tools::hgr {
                 assert(info[i].endBehaviour < BehaviourType::BEHAVIOUR_COUNT);
 
                 // not listed in the hgr file format documentation
-                if (version >= 192) memcpy(&info[i].isOptimized, at, 1); at += 1;
+                if (ctx.version >= 192) info[i].isOptimized = (*at != 0);
+                at += 1;
 
                 if (!info[i].isOptimized) {
                     // not implementing rn
 
-                    info[i].posKeyData_uo = new keyframeSequence();
-                    info[i].rotKeyData = new keyframeSequence();
-                    info[i].sclKeyData_uo = new keyframeSequence();
+                    info[i].posKeyData_uo = ctx.arena->create<keyframeSequence>();
+                    info[i].rotKeyData = ctx.arena->create<keyframeSequence>();
+                    info[i].sclKeyData_uo = ctx.arena->create<keyframeSequence>();
 
-                    read_buffer(at, *info[i].posKeyData_uo);
-                    read_buffer(at, *info[i].rotKeyData);
-                    read_buffer(at, *info[i].sclKeyData_uo);
+                    if (!read_buffer(at, ctx, *info[i].posKeyData_uo) || !read_buffer(at, ctx, *info[i].rotKeyData) ||
+                        !read_buffer(at, ctx, *info[i].sclKeyData_uo)) return false;
                 }
                 else { // New Implementation
-                    info[i].posKeyData = new float3Animation();
-                    info[i].rotKeyData = new keyframeSequence(); // Only this remains same
-                    info[i].sclKeyData = new float3Animation();
+                    info[i].posKeyData = ctx.arena->create<float3Animation>();
+                    info[i].rotKeyData = ctx.arena->create<keyframeSequence>(); // Only this remains same
+                    info[i].sclKeyData = ctx.arena->create<float3Animation>();
 
                     read_float3anim(at, *info[i].posKeyData);
-                    read_buffer(at, *info[i].rotKeyData);
+                    if (!read_buffer(at, ctx, *info[i].rotKeyData)) return false;
                     read_float3anim(at, *info[i].sclKeyData);
 
                     info[i].endTime = 0.f;
-                    if (version >= 193) {
+                    if (ctx.version >= 193) {
                         memcpy(&(info[i].endTime), at, su32); at += su32;
                         info[i].endTime = swap_endian<f32>(info[i].endTime);
                     }
@@ -904,285 +862,672 @@ namespace tools::hgr {
             return true;
         }
 
-        void find_children(std::vector<node>& lNodes) {
-            int i{ 0 }; // if only i hadn't used an iterator
-            for (auto lNode : lNodes) {
-                ++i; if (lNode.parentIndex == 4294967295) continue;
+        // File Test -> levels that are known to ship with garbled string tables
+        bool is_known_corrupt(const char* path) {
+            static constexpr std::string_view levels[]{
+                "hypno_level01", "hypno_level02", "hypno_level03", "hypno_level04",
+                "mushroom_level01", "mushroom_level02", "mushroom_level03", "mushroom_level04",
+                "score_level01", "score_level02", "score_level03",
+                "skybean_level02", "skybean_level03", "skybean_level04",
+                "worldmap",
+            };
+
+            // File name without directory and extension, either kind of separator
+            std::string_view file{ path };
+            file = file.substr(file.find_last_of("\\/") + 1); // npos + 1 == 0
+            file = file.substr(0, file.find_last_of('.'));
+            return std::find(std::begin(levels), std::end(levels), file) != std::end(levels);
+        }
 
-                lNodes[lNode.parentIndex].childIndex.push_back(i);
-            }
-            return;
+        u32 read_count(const u8*& at) {
+            u32 count{ 0 };
+            memcpy(&count, at, su32); at += su32;
+            return swap_endian<u32>(count);
         }
 
-        bool read_file(std::filesystem::path path, std::unique_ptr<u8[]>& data, u64& size) {
-            if (!std::filesystem::exists(path)) return false;
-            assert(true);
+        // Signature, header, scene parameters and the initial check_id. Leaves 'at' on the first section.
+        bool read_header(const u8*& at, const u8* end, hgr_info& header, scene_param_info& sceneParams) {
+            constexpr u64 HEADER_BYTES{ 5 + 1 + su32 + su16 * 2 + 1 + su32 * 5 + su32 };
+            if (!fits(at, end, HEADER_BYTES)) return false;
+            if (!check_signature(at, header)) return false;
 
-            size = std::filesystem::file_size(path);
-            if (!size) return false;
-            data = std::make_unique<u8[]>(size);
-            std::ifstream file{ path, std::ios::in | std::ios::binary }; // Create a filestream
-            if (!file || !file.read((char*)data.get(), size)) {
-                file.close();
-                return false;
+            read_buffer(at, header);
+            read_buffer(at, sceneParams);
+
+            memcpy(&(header.check_id), at, su32); at += su32;
+            SWAP(header.check_id, u32);
+            return true;
+        }
+
+        // Row of the first node of a node section in the node table, nodes are numbered in file order
+        u32 first_node(const entity_info& count, Section section) {
+            const u32 counts[]{ count.Mesh_Count, count.Camera_Count, count.Light_Count,
+                                count.Dummy_Count, count.Shape_Count, count.OtherNodes_Count };
+            u32 first{ 0 };
+            for (u32 s{ SECTION_MESHES };s < u32(section);++s) first += counts[s - SECTION_MESHES];
+            return first;
+        }
+
+        // Decodes one section, its entity count included, into asset. Node sections write their nodes
+        // into their rows of asset.Nodes, link_nodes() builds the hierarchy once all of them are there.
+        bool decode_section(const u8*& at, parse_context& ctx, Section section, assetData& asset) {
+            entity_info& count = ctx.entityInfo;
+
+            switch (section) {
+            case SECTION_MATERIALS:
+                count.Texture_Count = read_count(at);
+                read_buffer(at, asset.texInfo, count.Texture_Count);
+                count.Material_Count = read_count(at);
+                return read_buffer(at, ctx, asset.matInfo, count.Material_Count);
+
+            case SECTION_PRIMITIVES:
+                count.Primitive_Count = read_count(at);
+                if (!read_buffer(at, ctx, asset.primInfo, count.Primitive_Count)) return false;
+#if TOOLS_WITH_STATS
+                for (const primitive_info& p : asset.primInfo) {
+                    stats::add(stats::COUNTER_VERTICES, p.verts);
+                    stats::add(stats::COUNTER_INDICES, p.indices);
+                }
+#endif
+                return build_geometry(asset.primInfo, *ctx.arena);
+
+            case SECTION_MESHES: {
+                count.Mesh_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.Mesh_Count);
+                asset.meshInfo = ctx.arena->create_array<mesh>(count.Mesh_Count);
+                return read_buffer(at, *ctx.arena, asset.Nodes, first, asset.meshInfo, count.Mesh_Count);
+            }
+
+            case SECTION_CAMERAS: {
+                count.Camera_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.Camera_Count);
+                asset.cameraInfo = ctx.arena->create_array<camera>(count.Camera_Count);
+                return read_buffer(at, asset.Nodes, first, asset.cameraInfo, count.Camera_Count);
+            }
+
+            case SECTION_LIGHTS: {
+                count.Light_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.Light_Count);
+                asset.lightInfo = ctx.arena->create_array<light>(count.Light_Count);
+                return read_buffer(at, asset.Nodes, first, asset.lightInfo, count.Light_Count);
+            }
+
+            case SECTION_DUMMIES: {
+                count.Dummy_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.Dummy_Count);
+                asset.dummyInfo = ctx.arena->create_array<dummy>(count.Dummy_Count);
+                return read_buffer(at, asset.Nodes, first, asset.dummyInfo, count.Dummy_Count);
             }
 
-            file.close();
+            case SECTION_SHAPES: {
+                count.Shape_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.Shape_Count);
+                asset.shapeinfo = ctx.arena->create_array<shape>(count.Shape_Count);
+                return read_buffer(at, *ctx.arena, asset.Nodes, first, asset.shapeinfo, count.Shape_Count);
+            }
+
+            case SECTION_OTHERNODES: { // no class data, only the node itself
+                count.OtherNodes_Count = read_count(at);
+                const u32 first = first_node(count, section);
+                asset.Nodes.reserve_rows(first + count.OtherNodes_Count);
+                for (u32 i{ 0 };i < count.OtherNodes_Count; ++i) {
+                    read_buffer(at, asset.Nodes, first + i);
+                }
+                return true;
+            }
+
+            case SECTION_TRANSFORMANIMATIONS:
+                count.TransformAnimation_Count = read_count(at);
+                asset.transAnim = ctx.arena->create_array<transformAnimation>(count.TransformAnimation_Count);
+                return read_buffer(at, ctx, asset.transAnim, count.TransformAnimation_Count);
+
+            case SECTION_USERPROPERTIES:
+                count.UserProperties_Count = read_count(at);
+                asset.userProp = ctx.arena->create_array<userProperty>(count.UserProperties_Count);
+                return read_buffer(at, asset.userProp, count.UserProperties_Count);
+
+            case SECTION_COUNT:
+                break;
+            }
+            return false;
+        }
+
+        constexpr const char* SECTION_ZONES[SECTION_COUNT]{
+            "parse.materials", "parse.primitives", "parse.meshes", "parse.cameras", "parse.lights",
+            "parse.dummies", "parse.shapes", "parse.othernodes", "parse.transformanimations", "parse.userproperties",
+        };
+
+        // decode_section() timed, and the bytes it took counted, as the stats and trace zone of the section
+        bool read_section(const u8*& at, parse_context& ctx, Section section, assetData& asset) {
+            stats::scoped_timer timer{ stats::Timer(stats::TIMER_PARSE_MATERIALS + u32(section)) };
+            trace::zone zone{ SECTION_ZONES[section] };
+            const u8* start{ at };
+            const bool ok = decode_section(at, ctx, section, asset);
+            stats::add(stats::Counter(stats::COUNTER_BYTES_MATERIALS + u32(section)), u64(at - start));
+            return ok;
+        }
+
+        // Builds the hierarchy of asset.Nodes, which needs every node section
+        void link_nodes(assetData& asset) {
+            stats::scoped_timer timer{ stats::TIMER_HIERARCHY };
+            trace::zone zone{ "hierarchy" };
+            asset.hierarchy.build(asset.Nodes.parents);
+        }
+
+        // -- Section index --
+        // The skip_* functions mirror the readers above, but only move 'at' along. Strings are stepped
+        // over and vertex / keyframe payloads are skipped by their computed sizes, nothing is allocated.
+        // Every step is checked against ctx.end first, so counts and lengths that run past the file
+        // fail the index instead of being followed. The readers rely on that: whatever decodes a section
+        // runs after its index entry has been checked.
+
+        bool skip(const u8*& at, const parse_context& ctx, u64 bytes) {
+            if (!fits(at, ctx.end, bytes)) return false;
+            at += bytes;
             return true;
         }
 
-    } // Anonymous Namespace
+        bool skip_count(const u8*& at, const parse_context& ctx, u32& count) {
+            if (!fits(at, ctx.end, su32)) return false;
+            count = read_count(at);
+            return true;
+        }
 
-    TOOL_INTERFACE bool StoreData(const char* path, const char* texpath, const char* outpath) {
+        bool skip_u8(const u8*& at, const parse_context& ctx, u32& value) {
+            if (!fits(at, ctx.end, 1)) return false;
+            value = *at++;
+            return true;
+        }
 
-        std::vector<node> hgrNodes;
-        { // File Test
-            std::string file = path;
-            file = file.substr(file.find_last_of("\\") + 1, file.length() - file.find_last_of("\\") - 5);
-            if (file._Equal("hypno_level01")) corrupt = true;
-            if (file._Equal("hypno_level02")) corrupt = true;
-            if (file._Equal("hypno_level03")) corrupt = true;
-            if (file._Equal("hypno_level04")) corrupt = true;
-            if (file._Equal("mushroom_level01")) corrupt = true;
-            if (file._Equal("mushroom_level02")) corrupt = true;
-            if (file._Equal("mushroom_level03")) corrupt = true;
-            if (file._Equal("mushroom_level04")) corrupt = true;
-            if (file._Equal("score_level01")) corrupt = true;
-            if (file._Equal("score_level02")) corrupt = true;
-            if (file._Equal("score_level03")) corrupt = true;
-            if (file._Equal("skybean_level02")) corrupt = true;
-            if (file._Equal("skybean_level03")) corrupt = true;
-            if (file._Equal("skybean_level04")) corrupt = true;
-            if (file._Equal("worldmap")) corrupt = true;
+        bool skip_string(const u8*& at, const parse_context& ctx) {
+            u16 size{ 0 };
+            if (!fits(at, ctx.end, su16)) return false;
+            memcpy(&size, at, su16); at += su16;
+            SWAP(size, u16);
+            return skip(at, ctx, size);
         }
 
-        std::unique_ptr<u8[]> buffer{};
-        u64 size{ 0 };
-        if (!read_file(path, buffer, size)) return false;
-        assert(buffer.get());
-        const u8* at{ buffer.get() };
-
-        if (!check_signature(at)) return false;
-
-        hgr_info* header = new hgr_info();
-        //std::shared_ptr<hgr::hgr_info> header{}; // I don't know why smart pointer is causing errors
-        read_buffer(at, *header);
-
-        version = header->m_ver;
-
-        scene_param_info* sceneParams = new scene_param_info();
-        read_buffer(at, *sceneParams);
-
-        memcpy(&(header->check_id), at, su32); at += su32;
-        SWAP(header->check_id, u32);
-
-        // TODO: replace array pointers with vector
-
-        memcpy(&(entityInfo.Texture_Count), at, su32); at += su32;
-        entityInfo.Texture_Count = swap_endian<u32>(entityInfo.Texture_Count);
-        std::vector<texture_info> Textures;
-        read_buffer(at, Textures, entityInfo.Texture_Count);
-
-        memcpy(&(entityInfo.Material_Count), at, su32); at += su32;
-        entityInfo.Material_Count = swap_endian<u32>(entityInfo.Material_Count);
-        std::vector<material_info> Materials;
-        read_buffer(at, Materials, entityInfo.Material_Count);
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Primitive_Count), at, su32); at += su32;
-        entityInfo.Primitive_Count = swap_endian<u32>(entityInfo.Primitive_Count);
-        std::vector<primitive_info> Primitives;
-        read_buffer(at, Primitives, entityInfo.Primitive_Count);
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Mesh_Count), at, su32); at += su32;
-        entityInfo.Mesh_Count = swap_endian<u32>(entityInfo.Mesh_Count);
-        mesh* Meshes = new mesh[entityInfo.Mesh_Count];
-        auto x = read_buffer(at, Meshes, entityInfo.Mesh_Count);
-
-        hgrNodes.insert(hgrNodes.end(),
-            std::make_move_iterator(x.begin()),
-            std::make_move_iterator(x.end()));
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Camera_Count), at, su32); at += su32;
-        entityInfo.Camera_Count = swap_endian<u32>(entityInfo.Camera_Count);
-        camera* Cameras = new camera[entityInfo.Camera_Count];
-        if (entityInfo.Camera_Count > 0) {
-            x = read_buffer(at, Cameras, entityInfo.Camera_Count);
-            hgrNodes.insert(hgrNodes.end(),
-                std::make_move_iterator(x.begin()),
-                std::make_move_iterator(x.end()));
-        }
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Light_Count), at, su32); at += su32;
-        entityInfo.Light_Count = swap_endian<u32>(entityInfo.Light_Count);
-        light* Lights = new light[entityInfo.Light_Count];
-        if (entityInfo.Light_Count > 0) {
-            x = read_buffer(at, Lights, entityInfo.Light_Count);
-            hgrNodes.insert(hgrNodes.end(),
-                std::make_move_iterator(x.begin()),
-                std::make_move_iterator(x.end()));
-        }
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Dummy_Count), at, su32); at += su32;
-        entityInfo.Dummy_Count = swap_endian<u32>(entityInfo.Dummy_Count);
-        dummy* Dummies = new dummy[entityInfo.Dummy_Count];
-        if (entityInfo.Dummy_Count > 0) {
-            x = read_buffer(at, Dummies, entityInfo.Dummy_Count);
-            hgrNodes.insert(hgrNodes.end(),
-                std::make_move_iterator(x.begin()),
-                std::make_move_iterator(x.end()));
-        }
-
-        check_id(at, *header);
-
-        memcpy(&(entityInfo.Shape_Count), at, su32); at += su32;
-        entityInfo.Shape_Count = swap_endian<u32>(entityInfo.Shape_Count);
-        shape* Shapes = new shape[entityInfo.Shape_Count];
-        if (entityInfo.Shape_Count > 0) {
-            x = read_buffer(at, Shapes, entityInfo.Shape_Count);
-            hgrNodes.insert(hgrNodes.end(),
-                std::make_move_iterator(x.begin()),
-                std::make_move_iterator(x.end()));
+        bool skip_node(const u8*& at, const parse_context& ctx) {
+            return skip_string(at, ctx) // name
+                && skip(at, ctx, su32 * 12 + su32 * 3); // modeltm, then nodeFlags, id, parentIndex
         }
 
-        check_id(at, *header);
+        // Bytes taken by a vertex stream or a keyframe array
+        u64 stream_bytes(VertexFormat::DataFormat df, u32 verts) {
+            return u64(VertexFormat::getDataSize(df)) * verts;
+        }
 
-        memcpy(&(entityInfo.OtherNodes_Count), at, su32); at += su32;
-        entityInfo.OtherNodes_Count = swap_endian<u32>(entityInfo.OtherNodes_Count);
-        node* otherNodes = new node[entityInfo.OtherNodes_Count];
-        if (entityInfo.OtherNodes_Count > 0) {
-            for (u32 i{ 0 };i < entityInfo.OtherNodes_Count; ++i) {
-                read_buffer(at, otherNodes[i]);
-                hgrNodes.push_back(otherNodes[i]);
-            }
+        // read_Float4Array16 / read_Float3Array16
+        bool skip_FloatArray16(const u8*& at, const parse_context& ctx, s32 count, u32 dim) {
+            if (count > 2) return skip(at, ctx, u64(su32) * dim * 2 + u64(su16) * dim * u32(count)); // min, max, then the quantized keys
+            if (count > 0) return skip(at, ctx, u64(su32) * dim * u32(count));
+            return true;
         }
 
-        check_id(at, *header);
+        bool skip_keyframes(const u8*& at, const parse_context& ctx) {
+            u32 keys{ 0 };
+            if (!skip_count(at, ctx, keys)) return false;
+            const s32 keyCount = s32(keys);
+
+            if (ctx.version < 192) {
+                u16 s{ 0 };
+                if (!fits(at, ctx.end, su16)) return false;
+                memcpy(&s, at, su16); at += su16; s = swap_endian<u16>(s);
+                if (!fits(at, ctx.end, s)) return false;
+                const VertexFormat::DataFormat df = VertexFormat::toDataFormat(std::string_view(reinterpret_cast<const char*>(at), s)); at += s;
+                if (!skip(at, ctx, su32 * 4)) return false; // scale + bias
 
-        memcpy(&(entityInfo.TransformAnimation_Count), at, su32); at += su32;
-        entityInfo.TransformAnimation_Count = swap_endian<u32>(entityInfo.TransformAnimation_Count);
-        transformAnimation* TransformAnimations = new transformAnimation[entityInfo.TransformAnimation_Count];
-        if (entityInfo.TransformAnimation_Count > 0) {
-            read_buffer(at, TransformAnimations, entityInfo.TransformAnimation_Count);
+                return keyCount <= 0 || skip(at, ctx, stream_bytes(df, u32(keyCount)));
+            }
+
+            u32 dim{ 0 };
+            if (!skip_count(at, ctx, dim)) return false;
+            if (dim != 3 && dim != 4) return false; // the reader knows no other layout
+            return skip_FloatArray16(at, ctx, keyCount, dim);
         }
-        
-        check_id(at, *header);
-        
-        memcpy(&(entityInfo.UserProperties_Count), at, su32); at += su32;
-        entityInfo.UserProperties_Count = swap_endian<u32>(entityInfo.UserProperties_Count);
-        userProperty* UserProperties  = new userProperty[entityInfo.UserProperties_Count];
-        if (entityInfo.UserProperties_Count > 0) {
-            read_buffer(at, UserProperties, entityInfo.UserProperties_Count);
+
+        bool skip_float3anim(const u8*& at, const parse_context& ctx) {
+            u32 keyCount{ 0 };
+            return skip_count(at, ctx, keyCount)
+                && skip_FloatArray16(at, ctx, s32(keyCount), 4); // stored like read_float3anim reads it
         }
 
-        // Check if all the data is read:
-        assert(at == (buffer.get() + size));
+        bool skip_primitives(const u8*& at, parse_context& ctx, u32 count) {
+            vertFormat formats[255]; // the stream sizes depend on them
+            for (u32 i{ 0 };i < count;++i) {
+                u32 verts{ 0 }, indices{ 0 };
+                if (ctx.version < 190) {
+                    u16 count16{ 0 };
+                    if (!fits(at, ctx.end, su16 * 2)) return false;
+                    memcpy(&count16, at, su16); at += su16;
+                    verts = swap_endian<u16>(count16);
+                    memcpy(&count16, at, su16); at += su16;
+                    indices = swap_endian<u16>(count16);
+                }
+                else {
+                    if (!skip_count(at, ctx, verts) || !skip_count(at, ctx, indices)) return false;
+                }
 
-        assetData Asset{};
-        // Fill Data
-        Asset.info = header;
-        Asset.scene_param = sceneParams;
-        Asset.entityInfo = &entityInfo;
-        Asset.texInfo = Textures;
-        Asset.matInfo = Materials;
-        Asset.primInfo = Primitives;
-
-        find_children(hgrNodes); // Should I remove it? I'm not using it rn...
-        Asset.Nodes = hgrNodes;
-
-        Asset.meshInfo = Meshes;
-        Asset.cameraInfo = Cameras;
-        Asset.lightInfo = Lights;
-        Asset.dummyInfo = Dummies;
-        Asset.shapeinfo = Shapes;
-        Asset.otherNodeInfo = otherNodes;
-
-        Asset.transAnim = TransformAnimations;
-        Asset.userProp = UserProperties;
+                u32 n{ 0 };
+                if (!skip_u8(at, ctx, n)) return false;
+                u8 formatCount{ u8(n) };
+                vertFormat* lFormats = formats;
+                if (!read_buffer(at, ctx, lFormats, formatCount)) return false;
 
-        // TODO:
-        // connect bones
-        // connect lights to Meshes
+                if (verts == 24 && indices == 162 && ctx.corrupt) { // Error Case
+                    verts = 56;
+                }
+                ctx.vertexCount += verts;
+                ctx.indexCount += indices;
 
-        CreateFBX(Asset, path, texpath, outpath); // FBX Exporter
+                u64 bytes{ su16 * 2 }; // matIndex + primitiveType
+                if (ctx.version >= 190) bytes += su32 * 8; // posscalebias + uvscalebias
 
-        // to avoid memory leaks
-        u32 i{ 0 };
-        {
-            delete header;
-            delete sceneParams;
-            Textures.clear();
-            for (i = 0;i < entityInfo.Material_Count;++i) {
-                delete[] Materials[i].TexParams;
-                delete[] Materials[i].Vec4Params;
-                delete[] Materials[i].FloatParams;
+                for (u32 j{ 0 };j < formatCount;++j) {
+                    if (ctx.version < 190) bytes += su32 * 5; // dummy scale + bias4
+                    bytes += stream_bytes(formats[j].format, verts);
+                }
+
+                bytes += u64(su16) * indices;
+                if (!skip(at, ctx, bytes)) return false;
+
+                u32 usedBoneCount{ 0 };
+                if (!skip_u8(at, ctx, usedBoneCount) || !skip(at, ctx, usedBoneCount)) return false;
             }
-            for (i = 0;i < entityInfo.Primitive_Count;++i) {
-                delete[] Primitives[i].formats;
-                for (u32 j{ 0 };j < Primitives[i].formatCount;++j) {
-                    delete[] Primitives[i].vArray[j].value;
+            return true;
+        }
+
+        bool skip_animations(const u8*& at, const parse_context& ctx, u32 count) {
+            for (u32 i{ 0 };i < count;++i) {
+                if (!skip_string(at, ctx)) return false; // node name
+                if (!fits(at, ctx.end, 5)) return false; // key rates + end behaviour, isOptimized
+                at += 4;
+
+                bool isOptimized{ false };
+                if (ctx.version >= 192) isOptimized = (*at != 0);
+                at += 1; // read_buffer(transformAnimation) always steps over this byte
+
+                if (!isOptimized) {
+                    if (!skip_keyframes(at, ctx) || !skip_keyframes(at, ctx) || !skip_keyframes(at, ctx)) return false;
+                }
+                else {
+                    if (!skip_float3anim(at, ctx) || !skip_keyframes(at, ctx) || !skip_float3anim(at, ctx)) return false;
+                    if (ctx.version >= 193 && !skip(at, ctx, su32)) return false; // endTime
                 }
-                delete[] Primitives[i].vArray;
-                delete[] Primitives[i].indexData;
-                delete[] Primitives[i].usedBones;
             }
-            for (i = 0;i < entityInfo.Mesh_Count;++i) {
-                delete[] Meshes[i].primIndex;
-                delete[] Meshes[i].meshbone;
+            return true;
+        }
+
+        // Fixed bytes each node class has after skip_node()
+        u64 node_payload(Section section) {
+            switch (section) {
+            case SECTION_CAMERAS:   return su32 * 3; // front, back, FOV
+            case SECTION_LIGHTS:    return su32 * 9 + 1; // colour, 6 floats, type
+            case SECTION_DUMMIES:   return su32 * 6; // box
+            default:                return 0;
             }
-            delete[] Meshes;
-            delete[] Cameras;
-            delete[] Lights;
-            delete[] Dummies;
-            for (i = 0;i < entityInfo.Shape_Count;++i) {
-                delete[] Shapes[i].lines;
-                delete[] Shapes[i].paths;
+        }
+
+        bool skip_section(const u8*& at, parse_context& ctx, Section section) {
+            entity_info& count = ctx.entityInfo;
+            u32 i{ 0 }, n{ 0 };
+
+            switch (section) {
+            case SECTION_MATERIALS:
+                if (!skip_count(at, ctx, count.Texture_Count)) return false;
+                for (i = 0;i < count.Texture_Count;++i) {
+                    if (!skip_string(at, ctx) || !skip(at, ctx, su32)) return false; // name, type
+                }
+                if (!skip_count(at, ctx, count.Material_Count)) return false;
+                for (i = 0;i < count.Material_Count;++i) {
+                    std::string_view shaderName{};
+                    if (!skip_string(at, ctx) || !read_shader_name(at, ctx, shaderName)) return false; // name, shaderName
+                    if (!skip(at, ctx, su32)) return false; // lightmap_info
+
+                    // tex params, vec4 params, float params: a name and a value each
+                    for (const u32 valueBytes : { su16, su32 * 4, su32 }) {
+                        if (!skip_u8(at, ctx, n)) return false;
+                        for (u32 j{ 0 };j < n;++j) {
+                            if (!skip_string(at, ctx) || !skip(at, ctx, valueBytes)) return false;
+                        }
+                    }
+                }
+                return true;
+
+            case SECTION_PRIMITIVES:
+                return skip_count(at, ctx, count.Primitive_Count)
+                    && skip_primitives(at, ctx, count.Primitive_Count);
+
+            case SECTION_MESHES:
+                if (!skip_count(at, ctx, count.Mesh_Count)) return false;
+                for (i = 0;i < count.Mesh_Count;++i) {
+                    if (!skip_node(at, ctx)) return false;
+                    if (!skip_count(at, ctx, n) || !skip(at, ctx, u64(su32) * n)) return false; // primIndex
+                    if (!skip_count(at, ctx, n) || !skip(at, ctx, u64(su32 + su32 * 12) * n)) return false; // meshbones
+                }
+                return true;
+
+            case SECTION_CAMERAS:
+            case SECTION_LIGHTS:
+            case SECTION_DUMMIES:
+            case SECTION_OTHERNODES: {
+                u32& nodes = section == SECTION_CAMERAS ? count.Camera_Count
+                           : section == SECTION_LIGHTS ? count.Light_Count
+                           : section == SECTION_DUMMIES ? count.Dummy_Count
+                           : count.OtherNodes_Count;
+                if (!skip_count(at, ctx, nodes)) return false;
+                for (i = 0;i < nodes;++i) {
+                    if (!skip_node(at, ctx) || !skip(at, ctx, node_payload(section))) return false;
+                }
+                return true;
             }
-            delete[] Shapes;
-            delete[] otherNodes;
-            for (i = 0;i < entityInfo.TransformAnimation_Count;++i) {
-                if (!(TransformAnimations[i].isOptimized)) {
-                    delete TransformAnimations[i].posKeyData_uo;
-                    delete TransformAnimations[i].rotKeyData;
-                    delete TransformAnimations[i].sclKeyData_uo;
+
+            case SECTION_SHAPES:
+                if (!skip_count(at, ctx, count.Shape_Count)) return false;
+                for (i = 0;i < count.Shape_Count;++i) {
+                    u32 lines{ 0 }, paths{ 0 };
+                    if (!skip_node(at, ctx) || !skip_count(at, ctx, lines) || !skip_count(at, ctx, paths)) return false;
+                    if (!skip(at, ctx, u64(su32) * 6 * lines + u64(su32) * 2 * paths)) return false;
                 }
-                else {
-                    delete TransformAnimations[i].posKeyData;
-                    delete TransformAnimations[i].rotKeyData;
-                    delete TransformAnimations[i].sclKeyData;
+                return true;
+
+            case SECTION_TRANSFORMANIMATIONS:
+                return skip_count(at, ctx, count.TransformAnimation_Count)
+                    && skip_animations(at, ctx, count.TransformAnimation_Count);
+
+            case SECTION_USERPROPERTIES:
+                if (!skip_count(at, ctx, count.UserProperties_Count)) return false;
+                for (i = 0;i < count.UserProperties_Count;++i) {
+                    if (!skip_string(at, ctx) || !skip_string(at, ctx)) return false; // node name, property text
                 }
+                return true;
+
+            case SECTION_COUNT:
+                break;
+            }
+            return false;
+        }
+
+        // Fails on anything that doesn't fit the file: a count or length running past its end, a
+        // check_id out of sequence or bytes left over after the last section
+        bool build_index(const u8* data, u64 size, parse_context& ctx, section_index& index) {
+            const u8* at{ data };
+            ctx.end = data + size;
+            if (!read_header(at, ctx.end, index.info, index.sceneParams)) return false;
+            ctx.version = index.info.m_ver;
+
+            for (u32 section{ 0 };section < SECTION_COUNT;++section) {
+                if (section > 0) {
+                    if (!fits(at, ctx.end, su32) || !check_id(at, index.info)) return false;
+                }
+
+                section_info& info = index.sections[section];
+                info.offset = static_cast<u64>(at - data);
+                if (!skip_section(at, ctx, Section(section))) return false;
+                info.size = static_cast<u64>(at - data) - info.offset;
+            }
+
+            index.entities = ctx.entityInfo;
+            index.vertexCount = ctx.vertexCount;
+            index.indexCount = ctx.indexCount;
+            return at == data + size;
+        }
+
+    } // Anonymous Namespace
+
+    const std::vector<tools::math::float4>& position_keys(const transformAnimation& anim) {
+        static const std::vector<tools::math::float4> none{};
+        if (anim.isOptimized) return anim.posKeyData ? anim.posKeyData->keys : none;
+        return anim.posKeyData_uo ? anim.posKeyData_uo->keys : none;
+    }
+
+    const std::vector<tools::math::float4>& scale_keys(const transformAnimation& anim) {
+        static const std::vector<tools::math::float4> none{};
+        if (anim.isOptimized) return anim.sclKeyData ? anim.sclKeyData->keys : none;
+        return anim.sclKeyData_uo ? anim.sclKeyData_uo->keys : none;
+    }
+
+    bool SectionLoader::open(const char* path) {
+        _asset = {};
+        _arena.release();
+        _index = {};
+        for (bool& loaded : _loaded) loaded = false;
+
+        if (!_file.open(path)) return false;
+        _corrupt = is_known_corrupt(path);
+
+        parse_context ctx{};
+        ctx.corrupt = _corrupt;
+        if (!build_index(_file.data(), _file.size(), ctx, _index)) {
+            _file.close();
+            return false;
+        }
+
+        _asset.info = &_index.info;
+        _asset.scene_param = &_index.sceneParams;
+        _asset.entityInfo = &_index.entities;
+        return true;
+    }
+
+    bool SectionLoader::load(Section section) {
+        assert(_file.is_open() && section < SECTION_COUNT);
+        if (_loaded[section]) return true;
+
+        parse_context ctx{};
+        ctx.version = _index.info.m_ver;
+        ctx.corrupt = _corrupt;
+        ctx.entityInfo = _index.entities;
+        ctx.arena = &_arena;
+
+        // open() checked the section against the file, the decoder gets no more than its extent and
+        // has to use all of it
+        const section_info& info = _index.sections[section];
+        const u8* at{ _file.data() + info.offset };
+        ctx.end = at + info.size;
+        if (!read_section(at, ctx, section, _asset) || at != ctx.end) return false;
+        _loaded[section] = true;
+
+        // The hierarchy can only be put together once every node class is there
+        if (section >= SECTION_MESHES && section <= SECTION_OTHERNODES) {
+            for (u32 s{ SECTION_MESHES };s <= SECTION_OTHERNODES;++s) {
+                if (!_loaded[s]) return true;
             }
-            delete[] TransformAnimations;
-            delete[] UserProperties;
+            link_nodes(_asset);
+        }
+        return true;
+    }
+
+    bool SectionLoader::load_nodes() {
+        for (u32 s{ SECTION_MESHES };s <= SECTION_OTHERNODES;++s) {
+            if (!load(Section(s))) return false;
         }
+        return true;
+    }
 
+    bool probe(const char* path, hgr_probe& result) {
+        MappedFile file{};
+        if (!file.open(path)) return false;
+
+        parse_context ctx{};
+        ctx.corrupt = is_known_corrupt(path);
+
+        section_index index{};
+        if (!build_index(file.data(), file.size(), ctx, index)) return false;
+
+        result.info = index.info;
+        result.entities = index.entities;
+        result.vertexCount = index.vertexCount;
+        result.indexCount = index.indexCount;
+
+        // The texture table is the only payload a probe decodes
+        const u8* at{ file.data() + index.sections[SECTION_MATERIALS].offset };
+        u32 textureCount = read_count(at);
+        result.textures.clear();
+        result.textures.reserve(textureCount);
+        return read_buffer(at, result.textures, textureCount);
+    }
+
+    // Read-only counterpart of StoreData for inventories, nothing gets exported. Texture names are
+    // written to 'textures' separated by '\n' and cut off at 'texturesSize' (including the terminator).
+    // Any output pointer may be null.
+    TOOL_INTERFACE bool ProbeData(const char* path, hgr_info* info, entity_info* entities,
+                                  u64* vertexCount, u64* indexCount, char* textures, u32 texturesSize) {
+        hgr_probe result{};
+        if (!probe(path, result)) return false;
+
+        if (info) *info = result.info;
+        if (entities) *entities = result.entities;
+        if (vertexCount) *vertexCount = result.vertexCount;
+        if (indexCount) *indexCount = result.indexCount;
+
+        if (textures && texturesSize > 0) {
+            std::string names{};
+            for (const auto& texture : result.textures) {
+                if (!names.empty()) names += '\n';
+                names += texture.name;
+            }
+            const size_t length = std::min<size_t>(names.size(), texturesSize - 1);
+            memcpy(textures, names.data(), length);
+            textures[length] = '\0';
+        }
+        return true;
+    }
+
+    // Converts one .hgr file into an .fbx in outpath. Builds without the FBX exporter only parse it.
+    TOOL_INTERFACE bool StoreData(const char* path, [[maybe_unused]] const char* texpath, [[maybe_unused]] const char* outpath) {
+
+        stats::file_scope fileStats{ path }; // published when we return, whichever way
+        trace::zone zone{ "StoreData", path };
+
+        // The file stays mapped until we return, vertex and index data are views into it.
+        // Everything else the parse allocates lives in the arena and goes away with it.
+        MappedFile file{};
+        Arena arena{};
+
+        parse_context ctx{};
+        ctx.corrupt = is_known_corrupt(path);
+        ctx.arena = &arena;
+
+        {
+            stats::scoped_timer timer{ stats::TIMER_FILE_OPEN };
+            trace::zone openZone{ "file.open" };
+            if (!file.open(path)) return false;
+        }
+        stats::add(stats::COUNTER_FILE_BYTES, file.size());
+
+        // The index checks every count and length against the file first, a truncated file or one
+        // that isn't an .hgr at all fails here. The decoders then get one indexed section at a time
+        // and have to end exactly where the index did.
+        section_index index{};
         {
-            entityNodes.clear();
-            entityInfo.Texture_Count = 0;
-            entityInfo.Material_Count = 0;
-            entityInfo.Primitive_Count = 0;
-            entityInfo.Mesh_Count = 0;
-            entityInfo.Camera_Count = 0;
-            entityInfo.Light_Count = 0;
-            entityInfo.Dummy_Count = 0;
-            entityInfo.Shape_Count = 0;
-            entityInfo.OtherNodes_Count = 0;
-            entityInfo.TransformAnimation_Count = 0;
-            entityInfo.UserProperties_Count = 0;
+            stats::scoped_timer timer{ stats::TIMER_INDEX };
+            trace::zone indexZone{ "index" };
+            if (!build_index(file.data(), file.size(), ctx, index)) return false;
+        }
+
+        assetData Asset{};
+        Asset.info = &index.info;
+        Asset.scene_param = &index.sceneParams;
+        Asset.entityInfo = &ctx.entityInfo;
+
+        for (u32 section{ 0 };section < SECTION_COUNT;++section) {
+            const section_info& info = index.sections[section];
+            const u8* at{ file.data() + info.offset };
+            ctx.end = at + info.size;
+            if (!read_section(at, ctx, Section(section), Asset) || at != ctx.end) return false;
         }
 
+        link_nodes(Asset);
+
+        // TODO:
+        // connect bones
+        // connect lights to Meshes
+
+#if TOOLS_WITH_FBX
+        try {
+            if (!CreateFBX(Asset, path, texpath, outpath)) return false; // FBX Exporter
+        }
+        catch (const std::exception&) { // unimplemented node types, or references the exporter can't follow
+            return false;
+        }
+#endif
+
         return true;
     }
 
+    // Converts 'count' files on a pool of 'threads' workers (0 = one per hardware thread).
+    // status[i] and seconds[i] receive the result and wall time of paths[i]; either may be null.
+    // Parsing runs fully in parallel, the FBX SDK part is serialized inside CreateFBX.
+    // Returns the number of files that converted successfully.
+    TOOL_INTERFACE u32 StoreDataBatch(const char** paths, u32 count, const char* texpath, const char* outpath,
+                                      u32 threads, bool* status, f64* seconds) {
+        std::atomic<u32> converted{ 0 };
+
+        parallel_for(count, threads, [&](u32 i) {
+            auto start = std::chrono::steady_clock::now();
+
+            bool ok{ false };
+            try {
+                ok = StoreData(paths[i], texpath, outpath);
+            }
+            catch (const std::exception&) { // e.g. unimplemented node types in the exporter
+                ok = false;
+            }
+
+            if (ok) converted.fetch_add(1, std::memory_order_relaxed);
+            if (status) status[i] = ok;
+            if (seconds) seconds[i] = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        });
+
+        return converted.load();
+    }
+
+    // Turns per-file stats collection on or off. Off by default, the instrumentation then costs a
+    // thread_local load per timer or counter.
+    TOOL_INTERFACE void EnableStats(bool enable) {
+        stats::set_enabled(enable);
+    }
+
+    // Writes the stats of the last StoreData of 'path' as JSON into 'json', cut off at 'jsonSize'
+    // (including the terminator). A null path gives {"files":[...]} with every file collected so far.
+    // Returns the size the whole string needs including the terminator, 0 if nothing was collected for path.
+    TOOL_INTERFACE u32 GetStats(const char* path, char* json, u32 jsonSize) {
+        const std::string out = stats::published_json(path);
+        if (out.empty()) {
+            if (json && jsonSize > 0) json[0] = '\0';
+            return 0;
+        }
+        if (json && jsonSize > 0) {
+            const size_t length = std::min<size_t>(out.size(), jsonSize - 1);
+            memcpy(json, out.data(), length);
+            json[length] = '\0';
+        }
+        return u32(out.size() + 1);
+    }
+
+    // Forgets every collected file
+    TOOL_INTERFACE void ClearStats() {
+        stats::clear_published();
+    }
+
+    // Starts recording a timeline of every StoreData on every thread: parse sections, vertex decode,
+    // exporter stages and file writes. Whatever an earlier recording kept is dropped.
+    TOOL_INTERFACE void BeginTrace() {
+        trace::start();
+    }
+
+    // Stops recording and writes the timeline to 'path' as Chrome trace_event JSON, for
+    // chrome://tracing or ui.perfetto.dev. Call it once the conversions are done.
+    TOOL_INTERFACE bool EndTrace(const char* path) {
+        trace::stop();
+        return trace::write(path);
+    }
+
     // Implement Later
     /*
     // connect bones
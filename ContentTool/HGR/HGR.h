@@ -1,7 +1,12 @@
 #pragma once
 #include <string.h>
+#include "../ToolCommon.h"
 #include "../Common/PrimitiveTypes.h"
+#include "../Common/Arena.h"
+#include "../Common/MappedFile.h"
 #include "HGRCommon.h"
+#include "Geometry.h"
+#include "Hierarchy.h"
 #include "Entity.h"
 
 #define MINVERSION 170
@@ -22,11 +27,12 @@ namespace tools::hgr {
 
 	struct hgr_info {
 		u16			m_ver{}; // major*100+minor
-		u32			m_exportedVer = 0x020903;
+		u32			m_exportedVer = 0x020903; // for m_ver > 190 only
 		u16			m_dataFlags{}; // <data-descriptor>
 		u32			m_platformID{}; // for m_ver > 180 only
 
 		u32			check_id {}; // initial value [hex] = 0x12345600 | Upon check_id(), increments by 0x1
+		u8			m_signature[5]{ 'h', 'g', 'r', 'f', 'i' }; // as it was in the file, not checked
 	};
 
 	struct scene_param_info {
@@ -72,25 +78,31 @@ namespace tools::hgr {
 		u32					indices{};
 		u8					formatCount{};
 		vertFormat*			formats{};
+		vertLayout			layout{};
 		u16					matIndex{};
 		u16					primitiveType{};
 		vertArray*			vArray{};
-		u16*				indexData{};
+		const u16*			indexData{}; // view into the mapped file, or a copy in the parse arena
 		u8					usedBoneCount{};
 		u8*					usedBones{};
+		primitive_geometry	geometry{}; // decoded streams, see build_geometry()
 	};
 
 	struct keyframeSequence {
 		s32											keyCount{};
-		std::string									dataFormat{};
+		VertexFormat::DataFormat					dataFormat{ VertexFormat::DF_NONE };
 		f32											scale{};
 		f32											bias[4]{};
+		f32											minv[4]{}; // quantization range, from version 192 with more than 2 keys
+		f32											maxv[4]{};
 		std::vector<tools::math::float4>			keys{};
 		u32											size{};
 	};
 
 	struct float3Animation {
 		s32											keyCount{};
+		f32											minv[4]{}; // quantization range, with more than 2 keys
+		f32											maxv[4]{};
 		std::vector<tools::math::float4>			keys{};
 	};
 
@@ -112,6 +124,11 @@ namespace tools::hgr {
 		f32					endTime{ 0.f }; // added in version 193
 	};
 
+	// Keys of the position and scale tracks: posKeyData/sclKeyData of optimized animations (version 192
+	// on), the _uo sequences otherwise. Empty if the track isn't there.
+	[[nodiscard]] const std::vector<tools::math::float4>& position_keys(const transformAnimation& anim);
+	[[nodiscard]] const std::vector<tools::math::float4>& scale_keys(const transformAnimation& anim);
+
 	struct userProperty {
 		std::string			nodeName{};
 		std::string			propertyText{};
@@ -127,24 +144,107 @@ namespace tools::hgr {
 	};
 
 	struct assetData {
-		hgr_info* info;
-		scene_param_info* scene_param;
-		entity_info* entityInfo;
+		hgr_info* info{};
+		scene_param_info* scene_param{};
+		entity_info* entityInfo{};
 
 		std::vector <texture_info> texInfo;
 		std::vector <material_info> matInfo;
 		std::vector <primitive_info> primInfo;
 
-		mesh* meshInfo;
-		camera* cameraInfo;
-		light* lightInfo;
-		dummy* dummyInfo;
-		shape* shapeinfo;
-		node* otherNodeInfo;
+		mesh* meshInfo{};
+		camera* cameraInfo{};
+		light* lightInfo{};
+		dummy* dummyInfo{};
+		shape* shapeinfo{};
+
+		transformAnimation* transAnim{};
+		userProperty* userProp{};
+
+		node_table Nodes; // every node once, the class arrays above refer to it by index
+		node_hierarchy hierarchy; // children and traversal orders of Nodes
+	};
+
+	// Sections in the order they are stored, each one is preceded by a check_id (except the first)
+	enum Section {
+		SECTION_MATERIALS, // textures + materials
+		SECTION_PRIMITIVES,
+		SECTION_MESHES,
+		SECTION_CAMERAS,
+		SECTION_LIGHTS,
+		SECTION_DUMMIES,
+		SECTION_SHAPES,
+		SECTION_OTHERNODES,
+		SECTION_TRANSFORMANIMATIONS,
+		SECTION_USERPROPERTIES,
+
+		SECTION_COUNT
+	};
+
+	struct section_info {
+		u64					offset{}; // from the start of the file, points at the section's entity count
+		u64					size{}; // in bytes, the following check_id is not included
+	};
+
+	struct section_index {
+		hgr_info			info{};
+		scene_param_info	sceneParams{};
+		entity_info			entities{};
+		section_info		sections[SECTION_COUNT]{};
+		u64					vertexCount{}; // over all primitives
+		u64					indexCount{};
+	};
 
-		transformAnimation* transAnim;
-		userProperty* userProp;
+	// What an inventory needs to know about a file, see probe()
+	struct hgr_probe {
+		hgr_info					info{};
+		entity_info					entities{};
+		std::vector<texture_info>	textures{};
+		u64							vertexCount{};
+		u64							indexCount{};
+	};
 
-		std::vector<node> Nodes; // This holds the necessary data to refer to stuff
+	// Indexes the file without decoding any vertex, index or keyframe data and without exporting
+	// anything. Only the texture table is read. Returns false if the file can't be opened or indexed.
+	[[nodiscard]] bool probe(const char* path, hgr_probe& result);
+
+	// Maps a file, indexes its sections in one pass without decoding any of them, then decodes
+	// sections on demand. asset() only holds what has been loaded; asset().hierarchy is built
+	// once all the node sections (meshes .. other nodes) are there. open() fails on files whose
+	// counts don't fit them, load() on a section that doesn't decode to exactly its indexed extent.
+	class SectionLoader {
+	public:
+		SectionLoader() = default;
+
+		SectionLoader(const SectionLoader&) = delete;
+		SectionLoader& operator=(const SectionLoader&) = delete;
+
+		[[nodiscard]] bool open(const char* path);
+		[[nodiscard]] bool load(Section section);
+		[[nodiscard]] bool load_nodes();
+
+		[[nodiscard]] bool is_loaded(Section section) const { return _loaded[section]; }
+		[[nodiscard]] const section_index& index() const { return _index; }
+		[[nodiscard]] const assetData& asset() const { return _asset; }
+
+	private:
+		MappedFile			_file{};
+		Arena				_arena{}; // declared before _asset, everything in it must outlive the asset
+		section_index		_index{};
+		assetData			_asset{};
+		bool				_corrupt{ false };
+		bool				_loaded[SECTION_COUNT]{};
 	};
+
+	// C interface of the library, used by the app (ContentToolAPI.cs) and ka3d-convert. See HGR.cpp.
+	TOOL_INTERFACE bool ProbeData(const char* path, hgr_info* info, entity_info* entities,
+								  u64* vertexCount, u64* indexCount, char* textures, u32 texturesSize);
+	TOOL_INTERFACE bool StoreData(const char* path, const char* texpath, const char* outpath);
+	TOOL_INTERFACE u32 StoreDataBatch(const char** paths, u32 count, const char* texpath, const char* outpath,
+									  u32 threads, bool* status, f64* seconds);
+	TOOL_INTERFACE void EnableStats(bool enable);
+	TOOL_INTERFACE u32 GetStats(const char* path, char* json, u32 jsonSize);
+	TOOL_INTERFACE void ClearStats();
+	TOOL_INTERFACE void BeginTrace();
+	TOOL_INTERFACE bool EndTrace(const char* path);
 }
\ No newline at end of file
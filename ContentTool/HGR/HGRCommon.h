@@ -3,6 +3,7 @@
 #include "VertexFormat.h"
 #include <string.h>
 #include <map>
+#include <string>
 
 namespace tools::hgr {
 
@@ -21,15 +22,30 @@ namespace tools::hgr {
 		f32 value{};
 	};
 
-	struct vertFormat {
-		std::string type{};
-		std::string format{};
+	struct vertFormat { // resolved from the names in the file once, while parsing
+		VertexFormat::DataType type{ VertexFormat::DT_SIZE };
+		VertexFormat::DataFormat format{ VertexFormat::DF_NONE };
 	};
 
 	struct vertArray { // maybe i'll convert it to a class
 		f32 scale{};
 		f32 bias[4]{0};
-		s16* value{};
-		u32 size{};
+		VertexFormat::DataFormat format{ VertexFormat::DF_NONE };
+		// The stream in its native width (f32, s16, u8 or packed u16, see VertexFormat::decode).
+		// Points straight into the mapped file unless it had to be copied into the parse arena.
+		const void* value{};
+		u32 size{}; // components, dim * verts
+
+		template<typename T>
+		[[nodiscard]] const T* as() const { return static_cast<const T*>(value); }
+	};
+
+	// Which stream of a primitive holds each DataType, so channels are found without a search
+	struct vertLayout {
+		u8 stream[VertexFormat::DT_SIZE];
+
+		vertLayout() { memset(stream, u8_invalid_id, sizeof(stream)); }
+
+		[[nodiscard]] bool has(VertexFormat::DataType dt) const { return stream[dt] != u8_invalid_id; }
 	};
 }
@@ -0,0 +1,404 @@
+#include "HGRWriter.h"
+#include "HGR.h"
+#include "../ToolCommon.h"
+#include "../Common/Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string_view>
+
+namespace tools::hgr {
+
+    namespace {
+        constexpr u32 su16{ sizeof(u16) };
+        constexpr u32 su32{ sizeof(u32) };
+        constexpr u32 CHECK_ID_BASE{ 0x12345600 };
+
+        static_assert(sizeof(tools::math::float4) == sizeof(f32) * 4, "keys are written straight from float4 arrays");
+
+        // The write_buffer functions mirror the read_buffer ones in HGR.cpp field by field
+        struct write_context {
+            std::vector<u8>&        out;
+            u16                     version{ 0 };
+            u32                     checkId{ CHECK_ID_BASE };
+        };
+
+        void put(write_context& ctx, const void* data, size_t bytes) {
+            const u8* p = static_cast<const u8*>(data);
+            ctx.out.insert(ctx.out.end(), p, p + bytes);
+        }
+
+        // Counts and most scalars are big-endian
+        template<typename T>
+        void put_be(write_context& ctx, T value) {
+            SWAP(value, T);
+            put(ctx, &value, sizeof(T));
+        }
+
+        // Vertex, index and quantized key data, the header and the fog parameters are stored as they are
+        template<typename T>
+        void put_le(write_context& ctx, T value) { put(ctx, &value, sizeof(T)); }
+
+        bool put_string(write_context& ctx, std::string_view s) {
+            if (s.size() > u16_invalid_id) return false;
+            put_be<u16>(ctx, u16(s.size()));
+            put(ctx, s.data(), s.size());
+            return true;
+        }
+
+        void check_id(write_context& ctx) { put_be<u32>(ctx, ++ctx.checkId); }
+
+        bool write_header(write_context& ctx, const hgr_info& info, const scene_param_info& params) {
+            put(ctx, info.m_signature, sizeof(info.m_signature));
+
+            put_le<u8>(ctx, u8(info.m_ver));
+            put_le<u32>(ctx, info.m_exportedVer);
+            put_le<u16>(ctx, info.m_dataFlags);
+            put_le<u16>(ctx, u16(info.m_platformID));
+
+            put_le<u8>(ctx, params.fogType);
+            put_le<f32>(ctx, params.fogStart);
+            put_le<f32>(ctx, params.fogEnd);
+            put(ctx, params.fogColour, su32 * 3);
+
+            put_be<u32>(ctx, ctx.checkId);
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const std::vector<texture_info>& info) {
+            put_be<u32>(ctx, u32(info.size()));
+            for (const texture_info& t : info) {
+                if (!put_string(ctx, t.name)) return false;
+                put_le<s32>(ctx, t.type);
+            }
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const std::vector<material_info>& info) {
+            put_be<u32>(ctx, u32(info.size()));
+            for (const material_info& m : info) {
+                if (!put_string(ctx, m.name) || !put_string(ctx, m.shaderName)) return false;
+                put_be<s32>(ctx, m.lightmap_info);
+
+                put_le<u8>(ctx, m.texParamCount);
+                for (u8 i{ 0 };i < m.texParamCount;++i) {
+                    if (!put_string(ctx, m.TexParams[i].param_type)) return false;
+                    put_be<u16>(ctx, m.TexParams[i].texIndex);
+                }
+
+                put_le<u8>(ctx, m.vec4ParamCount);
+                for (u8 i{ 0 };i < m.vec4ParamCount;++i) {
+                    if (!put_string(ctx, m.Vec4Params[i].param_type)) return false;
+                    for (f32 v : m.Vec4Params[i].value) put_be<f32>(ctx, v);
+                }
+
+                put_le<u8>(ctx, m.floatParamCount);
+                for (u8 i{ 0 };i < m.floatParamCount;++i) {
+                    if (!put_string(ctx, m.FloatParams[i].param_type)) return false;
+                    put_be<f32>(ctx, m.FloatParams[i].value);
+                }
+            }
+            return true;
+        }
+
+        // The reader hands the position and uv scale-bias to their streams, they are taken back from there
+        void put_scalebias(write_context& ctx, const primitive_info& p, VertexFormat::DataType dt) {
+            f32 scalebias[4]{ 1, 0, 0, 0 };
+            if (p.layout.has(dt)) {
+                const vertArray& stream = p.vArray[p.layout.stream[dt]];
+                scalebias[0] = stream.scale;
+                std::copy_n(stream.bias, 3, scalebias + 1);
+            }
+            for (f32 v : scalebias) put_be<f32>(ctx, v);
+        }
+
+        bool write_buffer(write_context& ctx, const std::vector<primitive_info>& info) {
+            put_be<u32>(ctx, u32(info.size()));
+            for (const primitive_info& p : info) {
+                if (ctx.version < 190) { // 16-bit counts
+                    if (p.verts > u16_invalid_id || p.indices > u16_invalid_id) return false;
+                    put_be<u16>(ctx, u16(p.verts));
+                    put_be<u16>(ctx, u16(p.indices));
+                }
+                else {
+                    put_be<u32>(ctx, p.verts);
+                    put_be<u32>(ctx, p.indices);
+                }
+
+                put_le<u8>(ctx, p.formatCount);
+                for (u8 i{ 0 };i < p.formatCount;++i) {
+                    if (p.formats[i].format >= VertexFormat::DF_SIZE || p.formats[i].type >= VertexFormat::DT_SIZE) return false;
+                    put_string(ctx, VertexFormat::toString(p.formats[i].type));
+                    put_string(ctx, VertexFormat::toString(p.formats[i].format));
+                }
+
+                put_be<u16>(ctx, p.matIndex);
+                put_be<u16>(ctx, p.primitiveType);
+
+                if (ctx.version >= 190) {
+                    put_scalebias(ctx, p, VertexFormat::DT_POSITION);
+                    put_scalebias(ctx, p, VertexFormat::DT_TEX0);
+                }
+
+                for (u8 i{ 0 };i < p.formatCount;++i) {
+                    if (ctx.version < 190) ctx.out.resize(ctx.out.size() + su32 * 5); // dummy scale + bias4
+
+                    const size_t bytes = size_t(VertexFormat::getDataSize(p.formats[i].format)) * p.verts;
+                    if (bytes && !p.vArray[i].value) return false;
+                    put(ctx, p.vArray[i].value, bytes);
+                }
+
+                if (p.indices && !p.indexData) return false;
+                put(ctx, p.indexData, size_t(su16) * p.indices);
+
+                put_le<u8>(ctx, p.usedBoneCount);
+                put(ctx, p.usedBones, p.usedBoneCount);
+            }
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, u32 i) {
+            if (i >= nodes.size() || !put_string(ctx, nodes.names[i])) return false;
+
+            const math::float3x4& modeltm = nodes.modeltm[i];
+            for (u32 j{ 0 };j < 3;++j) { // 3 rows 4 columns
+                put_be<f32>(ctx, modeltm.x[j]);
+                put_be<f32>(ctx, modeltm.y[j]);
+                put_be<f32>(ctx, modeltm.z[j]);
+                put_be<f32>(ctx, modeltm.w[j]);
+            }
+
+            put_be<u32>(ctx, nodes.nodeFlags[i]);
+            put_be<u32>(ctx, nodes.ids[i]);
+            put_be<u32>(ctx, nodes.parents[i]);
+            return true;
+        }
+
+        void write_buffer(write_context& ctx, const math::float3& v) {
+            for (f32 c : v.x) put_be<f32>(ctx, c);
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, const mesh& info) {
+            if (!write_buffer(ctx, nodes, info.nodeIndex)) return false;
+
+            put_be<u32>(ctx, info.primCount);
+            for (u32 j{ 0 };j < info.primCount;++j) put_be<u32>(ctx, info.primIndex[j]);
+
+            put_be<u32>(ctx, info.meshboneCount);
+            for (u32 j{ 0 };j < info.meshboneCount;++j) {
+                const meshbone& bone = info.meshbones[j];
+                put_be<u32>(ctx, bone.boneNodeIndex);
+                for (u32 k{ 0 };k < 3;++k) {
+                    put_be<f32>(ctx, bone.invresttm.x[k]);
+                    put_be<f32>(ctx, bone.invresttm.y[k]);
+                    put_be<f32>(ctx, bone.invresttm.z[k]);
+                    put_be<f32>(ctx, bone.invresttm.w[k]);
+                }
+            }
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, const camera& info) {
+            if (!write_buffer(ctx, nodes, info.nodeIndex)) return false;
+            put_be<f32>(ctx, info.front);
+            put_be<f32>(ctx, info.back);
+            put_be<f32>(ctx, info.FOV);
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, const light& info) {
+            if (!write_buffer(ctx, nodes, info.nodeIndex)) return false;
+            write_buffer(ctx, info.colour);
+            for (f32 v : { info.reserved1, info.reserved2, info.farAttenStart, info.farAttenEnd, info.inner, info.outer }) {
+                put_be<f32>(ctx, v);
+            }
+            put_le<u8>(ctx, info.type);
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, const dummy& info) {
+            if (!write_buffer(ctx, nodes, info.nodeIndex)) return false;
+            write_buffer(ctx, info.boxMin);
+            write_buffer(ctx, info.boxMax);
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const node_table& nodes, const shape& info) {
+            if (!write_buffer(ctx, nodes, info.nodeIndex)) return false;
+            put_be<s32>(ctx, info.lineCount);
+            put_be<s32>(ctx, info.pathCount);
+            for (s32 j{ 0 };j < info.lineCount;++j) {
+                write_buffer(ctx, info.lines[j].start);
+                write_buffer(ctx, info.lines[j].end);
+            }
+            for (s32 j{ 0 };j < info.pathCount;++j) {
+                put_be<u32>(ctx, info.paths[j].beginLine);
+                put_be<u32>(ctx, info.paths[j].endLine);
+            }
+            return true;
+        }
+
+        // Count, then the class data of each node in the order they were read
+        template<typename T>
+        bool write_nodes(write_context& ctx, const node_table& nodes, const T* info, u32 count) {
+            put_be<u32>(ctx, count);
+            if (count && !info) return false; // section not loaded
+            for (u32 i{ 0 };i < count;++i) {
+                if (!write_buffer(ctx, nodes, info[i])) return false;
+            }
+            return true;
+        }
+
+        // Counterpart of read_Float4Array16 / read_Float3Array16: more than 2 keys go back to u16 over
+        // [lo, hi], which gives the same values the reader dequantized them from. An empty range
+        // (lo == hi) has lost its words, those are written as 0.
+        void write_FloatArray16(write_context& ctx, const std::vector<tools::math::float4>& keys, s32 count, u32 dim,
+                                const f32 (&lo)[4], const f32 (&hi)[4]) {
+            const f32* values = reinterpret_cast<const f32*>(keys.data());
+
+            if (count > 2) {
+                for (u32 k{ 0 };k < dim;++k) put_be<f32>(ctx, lo[k]);
+                for (u32 k{ 0 };k < dim;++k) put_be<f32>(ctx, hi[k]);
+
+                for (s32 i{ 0 };i < count;++i) {
+                    for (u32 k{ 0 };k < dim;++k) {
+                        const f32 delta = hi[k] - lo[k];
+                        const f32 t = delta != 0.f ? (values[i * 4 + k] - lo[k]) / delta : 0.f;
+                        put_le<u16>(ctx, u16(std::clamp(std::lround(t * 65535.f), 0l, 65535l)));
+                    }
+                }
+            }
+            else {
+                for (s32 i{ 0 };i < count;++i) {
+                    for (u32 k{ 0 };k < dim;++k) put_be<f32>(ctx, values[i * 4 + k]);
+                }
+            }
+        }
+
+        bool write_buffer(write_context& ctx, const keyframeSequence& info) {
+            if (info.keys.size() != size_t(std::max(info.keyCount, 0))) return false;
+            put_be<s32>(ctx, info.keyCount);
+
+            if (ctx.version < 192) {
+                const VertexFormat::FormatDesc& desc = VertexFormat::getDesc(info.dataFormat);
+                if (!desc.isFloat) return false;
+
+                put_string(ctx, desc.name);
+                put_be<f32>(ctx, info.scale);
+                for (u32 k{ 0 };k < 3;++k) put_be<f32>(ctx, info.bias[k]);
+
+                const f32* values = reinterpret_cast<const f32*>(info.keys.data());
+                for (s32 i{ 0 };i < info.keyCount;++i) {
+                    for (u32 k{ 0 };k < desc.dim;++k) put_be<f32>(ctx, values[i * 4 + k]);
+                }
+            }
+            else {
+                const u32 dim = info.dataFormat == VertexFormat::DF_V4_32 ? 4 : 3;
+                put_be<u32>(ctx, dim);
+                write_FloatArray16(ctx, info.keys, info.keyCount, dim, info.minv, info.maxv);
+            }
+            return true;
+        }
+
+        bool write_float3anim(write_context& ctx, const float3Animation& info) {
+            if (info.keys.size() != size_t(std::max(info.keyCount, 0))) return false;
+            put_be<s32>(ctx, info.keyCount);
+            write_FloatArray16(ctx, info.keys, info.keyCount, 4, info.minv, info.maxv); // read as 4 components
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const transformAnimation* info, u32 count) {
+            put_be<u32>(ctx, count);
+            if (count && !info) return false;
+
+            for (u32 i{ 0 };i < count;++i) {
+                const transformAnimation& a = info[i];
+                if (!put_string(ctx, a.nodeName)) return false;
+
+                put_le<u8>(ctx, a.posKeyRate);
+                put_le<u8>(ctx, a.rotKeyRate);
+                put_le<u8>(ctx, a.sclKeyRate);
+                put_le<u8>(ctx, a.endBehaviour);
+
+                if (a.isOptimized && ctx.version < 192) return false;
+                put_le<u8>(ctx, a.isOptimized ? 1 : 0);
+
+                if (!a.isOptimized) {
+                    if (!a.posKeyData_uo || !a.rotKeyData || !a.sclKeyData_uo) return false;
+                    if (!write_buffer(ctx, *a.posKeyData_uo) || !write_buffer(ctx, *a.rotKeyData) ||
+                        !write_buffer(ctx, *a.sclKeyData_uo)) return false;
+                }
+                else {
+                    if (!a.posKeyData || !a.rotKeyData || !a.sclKeyData) return false;
+                    if (!write_float3anim(ctx, *a.posKeyData) || !write_buffer(ctx, *a.rotKeyData) ||
+                        !write_float3anim(ctx, *a.sclKeyData)) return false;
+                    if (ctx.version >= 193) put_be<f32>(ctx, a.endTime);
+                }
+            }
+            return true;
+        }
+
+        bool write_buffer(write_context& ctx, const userProperty* info, u32 count) {
+            put_be<u32>(ctx, count);
+            if (count && !info) return false;
+            for (u32 i{ 0 };i < count;++i) {
+                if (!put_string(ctx, info[i].nodeName) || !put_string(ctx, info[i].propertyText)) return false;
+            }
+            return true;
+        }
+    } // Anonymous Namespace
+
+    bool write(const assetData& asset, std::vector<u8>& out) {
+        if (!asset.info || !asset.scene_param || !asset.entityInfo) return false;
+        const entity_info& count = *asset.entityInfo;
+        if (asset.texInfo.size() != count.Texture_Count || asset.matInfo.size() != count.Material_Count ||
+            asset.primInfo.size() != count.Primitive_Count) return false;
+
+        out.clear();
+        write_context ctx{ out, asset.info->m_ver };
+
+        if (!write_header(ctx, *asset.info, *asset.scene_param)) return false;
+
+        // Sections in file order, see Section
+        if (!write_buffer(ctx, asset.texInfo) || !write_buffer(ctx, asset.matInfo)) return false;
+        check_id(ctx);
+        if (!write_buffer(ctx, asset.primInfo)) return false;
+        check_id(ctx);
+        if (!write_nodes(ctx, asset.Nodes, asset.meshInfo, count.Mesh_Count)) return false;
+        check_id(ctx);
+        if (!write_nodes(ctx, asset.Nodes, asset.cameraInfo, count.Camera_Count)) return false;
+        check_id(ctx);
+        if (!write_nodes(ctx, asset.Nodes, asset.lightInfo, count.Light_Count)) return false;
+        check_id(ctx);
+        if (!write_nodes(ctx, asset.Nodes, asset.dummyInfo, count.Dummy_Count)) return false;
+        check_id(ctx);
+        if (!write_nodes(ctx, asset.Nodes, asset.shapeinfo, count.Shape_Count)) return false;
+        check_id(ctx);
+
+        // Other nodes have no class data, they are the last rows of the node table
+        const u32 firstOther = count.Mesh_Count + count.Camera_Count + count.Light_Count + count.Dummy_Count + count.Shape_Count;
+        put_be<u32>(ctx, count.OtherNodes_Count);
+        for (u32 i{ 0 };i < count.OtherNodes_Count;++i) {
+            if (!write_buffer(ctx, asset.Nodes, firstOther + i)) return false;
+        }
+        check_id(ctx);
+
+        if (!write_buffer(ctx, asset.transAnim, count.TransformAnimation_Count)) return false;
+        check_id(ctx);
+        return write_buffer(ctx, asset.userProp, count.UserProperties_Count);
+    }
+
+    bool save(const char* path, const assetData& asset) {
+        std::vector<u8> data;
+        {
+            trace::zone zone{ "hgr.write" };
+            if (!write(asset, data)) return false;
+        }
+
+        trace::zone zone{ "hgr.save", path };
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        return bool(file);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "../Common/PrimitiveTypes.h"
+#include <vector>
+
+namespace tools::hgr {
+
+	struct assetData;
+
+	// Writes asset back out in the layout StoreData reads, for version asset.info->m_ver, with every
+	// section loaded. Vertex and index streams are written in the format they have, position/uv scale-bias
+	// included from 190 on, keyframe tracks of more than 2 keys from 192 on are quantized again over the
+	// range they were read with. What the reader doesn't keep is written the way the exporter does:
+	// check_ids counting up from 0x12345600, zeros for the unused pre-190 stream scale/bias and the
+	// pre-192 isOptimized byte, and zero words for key components whose range is empty (min == max, they
+	// decode to min whatever the words are). A file that follows that layout reads back and writes out
+	// byte for byte; one with other words in an empty range comes back with the same keys but not the same bytes.
+	// Returns false if a section isn't loaded or doesn't fit the version.
+	[[nodiscard]] bool write(const assetData& asset, std::vector<u8>& out);
+
+	// write() into a file, replacing it
+	[[nodiscard]] bool save(const char* path, const assetData& asset);
+}
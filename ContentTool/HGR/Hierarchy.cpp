@@ -0,0 +1,64 @@
+#include "Hierarchy.h"
+
+namespace tools::hgr {
+
+	void node_hierarchy::build(std::span<const u32> nodeParents) {
+		const u32 count = u32(nodeParents.size());
+
+		parents.resize(count);
+		for (u32 i{ 0 };i < count;++i) {
+			parents[i] = nodeParents[i] < count ? nodeParents[i] : u32_invalid_id;
+		}
+
+		// Cut parent cycles: walk up from every node that hasn't been seen, a node already on the
+		// current walk means the link just taken closes a loop
+		{
+			enum : u8 { UNSEEN, ON_WALK, DONE };
+			std::vector<u8> state(count, UNSEEN);
+			for (u32 i{ 0 };i < count;++i) {
+				u32 at{ i }, last{ u32_invalid_id };
+				while (at != u32_invalid_id && state[at] == UNSEEN) {
+					state[at] = ON_WALK;
+					last = at;
+					at = parents[at];
+				}
+				if (at != u32_invalid_id && state[at] == ON_WALK) parents[last] = u32_invalid_id;
+
+				for (at = i;at != u32_invalid_id && state[at] == ON_WALK;at = parents[at]) state[at] = DONE;
+			}
+		}
+
+		// Pass one counts the children of every node (top level ones under the virtual root),
+		// pass two drops them into place
+		offsets.assign(size_t(count) + 2, 0);
+		for (u32 i{ 0 };i < count;++i) {
+			++offsets[(parents[i] == u32_invalid_id ? count : parents[i]) + 1];
+		}
+		for (u32 i{ 0 };i <= count;++i) offsets[i + 1] += offsets[i];
+
+		children.resize(count);
+		std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+		for (u32 i{ 0 };i < count;++i) {
+			children[fill[parents[i] == u32_invalid_id ? count : parents[i]]++] = i;
+		}
+
+		// Preorder with an explicit stack, children pushed in reverse so they come out in file order
+		depthFirst.clear();
+		depthFirst.reserve(count);
+		std::vector<u32> stack(roots().rbegin(), roots().rend());
+		while (!stack.empty()) {
+			const u32 at = stack.back(); stack.pop_back();
+			depthFirst.push_back(at);
+			auto c = children_of(at);
+			stack.insert(stack.end(), c.rbegin(), c.rend());
+		}
+
+		// Level order, the output doubles as the queue
+		breadthFirst.assign(roots().begin(), roots().end());
+		breadthFirst.reserve(count);
+		for (size_t k{ 0 };k < breadthFirst.size();++k) {
+			auto c = children_of(breadthFirst[k]);
+			breadthFirst.insert(breadthFirst.end(), c.begin(), c.end());
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "../Common/PrimitiveTypes.h"
+#include <span>
+#include <vector>
+
+namespace tools::hgr {
+
+	// Parent -> children adjacency of the scene nodes in compressed sparse row form: the children of node i
+	// are children[offsets[i] .. offsets[i + 1]), in file order. Top level nodes are stored the same way
+	// under a virtual root at index size(). Both traversal orders are computed once by build(), so walking
+	// the tree afterwards never allocates.
+	struct node_hierarchy {
+		std::vector<u32>		parents{}; // u32_invalid_id for top level nodes
+		std::vector<u32>		offsets{}; // size() + 2 entries
+		std::vector<u32>		children{};
+		std::vector<u32>		depthFirst{}; // preorder, every parent comes before its children
+		std::vector<u32>		breadthFirst{}; // level by level
+
+		// Builds the hierarchy from the parent index of every node. Parents that are out of range make a
+		// node top level, and so does the link that closes a parent cycle in a broken file.
+		void build(std::span<const u32> nodeParents);
+
+		[[nodiscard]] u32 size() const { return u32(parents.size()); }
+
+		[[nodiscard]] std::span<const u32> children_of(u32 i) const {
+			return { children.data() + offsets[i], children.data() + offsets[i + 1] };
+		}
+
+		[[nodiscard]] std::span<const u32> roots() const { return children_of(size()); }
+
+		// f(u32 node) for every node, parents first
+		template<typename F>
+		void depth_first(F&& f) const { for (u32 i : depthFirst) f(i); }
+
+		template<typename F>
+		void breadth_first(F&& f) const { for (u32 i : breadthFirst) f(i); }
+	};
+}
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <map>
-#include <string>
+#include "../Common/PrimitiveTypes.h"
+#include "../Common/Dequantize.h"
+#include <string.h>
+#include <string_view>
 
 namespace tools::VertexFormat {
 	enum DataFormat
@@ -67,17 +69,204 @@ namespace tools::VertexFormat {
 		/** Number of different vertex component types. */
 		DT_SIZE
 	};
-	
+
+	// Everything the tools need to know about a DataFormat. Names are stored without the "DF_" prefix,
+	// the way they appear in .hgr files.
+	struct FormatDesc {
+		const char*		name;
+		u8				dim; // number of components
+		u8				componentSize; // bytes per component, 0 if the components are bit-packed
+		u8				size; // bytes per element
+		bool			isFloat;
+		bool			isSigned;
+		bool			normalized; // integer components map to [0,1] (or [-1,1] if signed)
+	};
+
+	inline constexpr FormatDesc FORMATS[] = {
+		{ "NONE",	0, 0, 0,	false,	false,	false },
+		{ "S_32",	1, 4, 4,	true,	true,	false },
+		{ "S_16",	1, 2, 2,	false,	true,	false },
+		{ "S_8",	1, 1, 1,	false,	false,	true },
+		{ "V2_32",	2, 4, 8,	true,	true,	false },
+		{ "V2_16",	2, 2, 4,	false,	true,	false },
+		{ "V2_8",	2, 1, 2,	false,	false,	true },
+		{ "V3_32",	3, 4, 12,	true,	true,	false },
+		{ "V3_16",	3, 2, 6,	false,	true,	false },
+		{ "V3_8",	3, 1, 3,	false,	false,	true },
+		{ "V4_32",	4, 4, 16,	true,	true,	false },
+		{ "V4_16",	4, 2, 8,	false,	true,	false },
+		{ "V4_8",	4, 1, 4,	false,	false,	true },
+		{ "V4_5",	4, 0, 2,	false,	false,	true }, // 5:5:5:1 in one u16, x in the low bits
+	};
+
+	inline constexpr const char* DATATYPE_NAMES[] = {
+		"DT_POSITION",
+		"DT_POSITIONT",
+		"DT_BONEWEIGHTS",
+		"DT_BONEINDICES",
+		"DT_NORMAL",
+		"DT_DIFFUSE",
+		"DT_SPECULAR",
+		"DT_TEX0",
+		"DT_TEX1",
+		"DT_TEX2",
+		"DT_TEX3",
+		"DT_TANGENT",
+	};
+
+	static_assert(sizeof(FORMATS) / sizeof(FORMATS[0]) == DF_SIZE);
+	static_assert(sizeof(DATATYPE_NAMES) / sizeof(DATATYPE_NAMES[0]) == DT_SIZE);
+
+	// The table has to agree with itself, the format names and the layout the file docs describe
+	consteval bool check_formats() {
+		for (u32 i{ 1 };i < DF_SIZE;++i) {
+			const FormatDesc& f = FORMATS[i];
+			if (f.componentSize && f.size != f.dim * f.componentSize) return false;
+			if (f.isFloat != (f.componentSize == 4)) return false;
+			if (std::string_view{ f.name }.back() - '0' != (f.componentSize ? f.componentSize * 8 : 5) % 10) return false;
+			if (std::string_view{ f.name }[f.dim == 1 ? 0 : 1] != (f.dim == 1 ? 'S' : '0' + f.dim)) return false;
+		}
+		return FORMATS[0].size == 0;
+	}
+	static_assert(check_formats(), "VertexFormat::FORMATS is out of sync with the DataFormat names");
+
 	// Returns data dimensions (in number of components) of specified data format.
-	int		
-	getDataDim(DataFormat df);
-	
+	[[nodiscard]] constexpr int
+	getDataDim(DataFormat df) { return df < DF_SIZE ? FORMATS[df].dim : 0; }
+
 	// Returns data size (in bytes) of specified data format.
-	int		
-	getDataSize(DataFormat df);
-
-	const char* toString(DataType dt);
-	const char* toString(DataFormat dt);
-	DataFormat toDataFormat(const char* str);
-	DataType toDataType(const char* str);
-}
\ No newline at end of file
+	[[nodiscard]] constexpr int
+	getDataSize(DataFormat df) { return df < DF_SIZE ? FORMATS[df].size : 0; }
+
+	[[nodiscard]] constexpr const FormatDesc&
+	getDesc(DataFormat df) { return FORMATS[df < DF_SIZE ? df : DF_NONE]; }
+
+	static_assert(getDataDim(DF_V3_16) == 3 && getDataSize(DF_V3_16) == 6);
+	static_assert(getDataDim(DF_V4_5) == 4 && getDataSize(DF_V4_5) == 2);
+
+	// -- Name lookup --
+	// Both name tables get a perfect hash, searched for at compile time: every name lands in its own
+	// slot, so a lookup is one hash and one compare.
+	namespace detail {
+		inline constexpr u32 HASH_SLOTS{ 32 };
+
+		constexpr u32 hash_name(std::string_view str, u32 seed) {
+			u32 h{ 2166136261u ^ seed }; // FNV-1a
+			for (char c : str) { h ^= u8(c); h *= 16777619u; }
+			return h ^ (h >> 15);
+		}
+
+		template<u32 TableSize>
+		struct PerfectHash {
+			u32			seed{};
+			u8			slot[TableSize]{}; // index into the name table, u8_invalid_id if empty
+		};
+
+		template<u32 TableSize, u32 Count>
+		consteval PerfectHash<TableSize> make_perfect_hash(const char* const (&names)[Count]) {
+			static_assert(Count < TableSize);
+			for (u32 seed{ 0 };;++seed) {
+				PerfectHash<TableSize> ph{ seed };
+				for (u8& s : ph.slot) s = 0xff;
+
+				bool collision{ false };
+				for (u32 i{ 0 };i < Count && !collision;++i) {
+					u8& s = ph.slot[hash_name(names[i], seed) % TableSize];
+					collision = (s != 0xff);
+					s = u8(i);
+				}
+				if (!collision) return ph;
+			}
+		}
+
+		consteval auto format_names() {
+			struct { const char* names[DF_SIZE]; } table{};
+			for (u32 i{ 0 };i < DF_SIZE;++i) table.names[i] = FORMATS[i].name;
+			return table;
+		}
+
+		inline constexpr auto FORMAT_NAMES = format_names();
+		inline constexpr auto FORMAT_HASH = make_perfect_hash<HASH_SLOTS>(FORMAT_NAMES.names);
+		inline constexpr auto DATATYPE_HASH = make_perfect_hash<HASH_SLOTS>(DATATYPE_NAMES);
+	}
+
+	[[nodiscard]] constexpr const char* toString(DataFormat df) { return getDesc(df).name; }
+	[[nodiscard]] constexpr const char* toString(DataType dt) { return dt < DT_SIZE ? DATATYPE_NAMES[dt] : ""; }
+
+	// Returns DF_SIZE for unknown names
+	[[nodiscard]] constexpr DataFormat toDataFormat(std::string_view str) {
+		const u8 i = detail::FORMAT_HASH.slot[detail::hash_name(str, detail::FORMAT_HASH.seed) % detail::HASH_SLOTS];
+		return (i != 0xff && str == FORMATS[i].name) ? DataFormat(i) : DF_SIZE;
+	}
+
+	// Returns DT_SIZE for unknown names
+	[[nodiscard]] constexpr DataType toDataType(std::string_view str) {
+		const u8 i = detail::DATATYPE_HASH.slot[detail::hash_name(str, detail::DATATYPE_HASH.seed) % detail::HASH_SLOTS];
+		return (i != 0xff && str == DATATYPE_NAMES[i]) ? DataType(i) : DT_SIZE;
+	}
+
+	static_assert(toDataFormat("V2_16") == DF_V2_16 && toDataFormat("DF_V2_16") == DF_SIZE);
+	static_assert(toDataType("DT_TEX0") == DT_TEX0 && toDataType("DT_TEX") == DT_SIZE);
+
+	// -- Decoding --
+	// FormatTraits<DF> is the compile-time view of FORMATS[DF]. decode<DF>() expands 'count' elements into
+	// 'dim' floats each, as component * scale + bias[k], where integer components of normalized formats
+	// are first brought into [0,1]. All per-format decisions happen at compile time, the loops don't branch.
+	// Streams are expected in their native width: f32 for the 32-bit formats, s16 for the 16-bit ones,
+	// bytes for the 8-bit ones and one u16 per element for DF_V4_5.
+
+	template<DataFormat DF>
+	struct FormatTraits {
+		static constexpr FormatDesc desc = FORMATS[DF];
+		static constexpr u32 dim = desc.dim;
+		static constexpr u32 size = desc.size;
+
+		// One component of element i
+		static f32 component(const u8* src, u32 i, u32 k) {
+			const u8* at = src + size * i + desc.componentSize * k;
+			if constexpr (desc.isFloat) {
+				f32 v; memcpy(&v, at, sizeof(v)); return v;
+			}
+			else if constexpr (desc.componentSize == 2) {
+				s16 v; memcpy(&v, at, sizeof(v)); return f32(v);
+			}
+			else if constexpr (desc.componentSize == 1) {
+				return f32(*at) * (1.f / 255.f);
+			}
+			else { // DF_V4_5
+				u16 v; memcpy(&v, src + size * i, sizeof(v));
+				return k < 3 ? f32((v >> (5 * k)) & 0x1f) * (1.f / 31.f) : f32(v >> 15);
+			}
+		}
+	};
+
+	template<DataFormat DF>
+	void decode(const void* src, u32 count, f32 scale, const f32* bias, f32* out) {
+		using traits = FormatTraits<DF>;
+		static_assert(traits::dim > 0, "DF_NONE can't be decoded");
+
+		const u8* bytes = static_cast<const u8*>(src);
+
+		// The integer formats go through the SIMD kernels, which give the same results as component()
+		if constexpr (traits::desc.componentSize == 2) { // the bulk of every level file
+			dequantize_s16(static_cast<const s16*>(src), count, traits::dim, scale, bias, out);
+		}
+		else if constexpr (traits::desc.componentSize == 1) {
+			dequantize_u8_unorm(bytes, count, traits::dim, scale, bias, out);
+		}
+		else if constexpr (DF == DF_V4_5) {
+			unpack_u16_5551(bytes, count, scale, bias, out);
+		}
+		else {
+			for (u32 i{ 0 };i < count;++i) {
+				for (u32 k{ 0 };k < traits::dim;++k) {
+					*out++ = traits::component(bytes, i, k) * scale + bias[k];
+				}
+			}
+		}
+	}
+
+	// Dispatches to decode<DF>() once per stream. 'out' needs room for count * getDataDim(df) floats.
+	// Returns false for DF_NONE and unknown formats.
+	bool decode(DataFormat df, const void* src, u32 count, f32 scale, const f32* bias, f32* out);
+}
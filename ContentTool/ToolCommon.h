@@ -2,13 +2,26 @@
 
 #include <assert.h>
 
-#define LITTLE_ENDIAN
+// Counts and most scalars in .hgr files are big-endian, they get swapped on little-endian hosts
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TOOLS_LITTLE_ENDIAN
+#endif
 
 #ifndef TOOL_INTERFACE
+#ifdef _WIN32
 #define TOOL_INTERFACE extern "C" __declspec(dllexport)
-#endif // !EDITOR_INTERFACE
+#else
+#define TOOL_INTERFACE extern "C" __attribute__((visibility("default")))
+#endif
+#endif // !TOOL_INTERFACE
+
+// The FBX exporter needs the Autodesk FBX SDK. Builds without it (see CMakeLists.txt) only parse.
+#ifndef TOOLS_WITH_FBX
+#define TOOLS_WITH_FBX 1
+#endif
 
 #include <climits>
+#include <cstddef>
 
 template <typename T>
 T swap_endian(T u) {
@@ -26,8 +39,8 @@ T swap_endian(T u) {
     return dest.u;
 }
 
-#ifdef LITTLE_ENDIAN
+#ifdef TOOLS_LITTLE_ENDIAN
 #define SWAP(x, TYPE) x = swap_endian<TYPE>(x) // ENABLED CODE
 #else
 #define SWAP(x, TYPE) //DISABLED CODE
-#endif // LITTLE_ENDIAN
\ No newline at end of file
+#endif // TOOLS_LITTLE_ENDIAN
\ No newline at end of file
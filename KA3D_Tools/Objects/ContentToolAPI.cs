@@ -1,4 +1,5 @@
 ﻿using System.Runtime.InteropServices;
+using System.Text;
 
 namespace KA3D_Tools
 {
@@ -11,5 +12,73 @@ namespace KA3D_Tools
         public static bool StoreHGR(string inputPath, string texturePath, string outputPath) {
             return StoreData(inputPath, texturePath, outputPath);
         }
+
+        [DllImport(_contentTool, CharSet = CharSet.Ansi)]
+        private static extern uint StoreDataBatch(string[] paths, uint count, string texpath, string outpath, uint threads,
+            [Out, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.U1)] bool[] status,
+            [Out] double[] seconds);
+        public static uint StoreHGRBatch(string[] inputPaths, string texturePath, string outputPath, out bool[] status, out double[] seconds) {
+            status = new bool[inputPaths.Length];
+            seconds = new double[inputPaths.Length];
+            // 0 threads -> one worker per hardware thread
+            return StoreDataBatch(inputPaths, (uint)inputPaths.Length, texturePath, outputPath, 0, status, seconds);
+        }
+
+        [DllImport(_contentTool)]
+        private static extern void EnableStats([MarshalAs(UnmanagedType.U1)] bool enable);
+        public static void EnableHGRStats(bool enable) {
+            EnableStats(enable);
+        }
+
+        [DllImport(_contentTool, CharSet = CharSet.Ansi)]
+        private static extern uint GetStats(string path, StringBuilder json, uint jsonSize);
+        // Per-stage timings and counters of the last conversion of inputPath as JSON, null if none were collected
+        public static string GetHGRStats(string inputPath) {
+            uint size = GetStats(inputPath, null, 0);
+            if (size == 0) return null;
+            var json = new StringBuilder((int)size);
+            GetStats(inputPath, json, size);
+            return json.ToString();
+        }
+
+        // Mirrors tools::hgr::hgr_info
+        [StructLayout(LayoutKind.Sequential)]
+        public struct HGRInfo {
+            public ushort Version;
+            public uint ExportedVersion;
+            public ushort DataFlags;
+            public uint PlatformID;
+            public uint CheckID;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = 5)]
+            public byte[] Signature;
+        }
+
+        // Mirrors tools::hgr::entity_info
+        [StructLayout(LayoutKind.Sequential)]
+        public struct EntityInfo {
+            public uint TextureCount;
+            public uint MaterialCount;
+            public uint PrimitiveCount;
+            public uint MeshCount;
+            public uint CameraCount;
+            public uint LightCount;
+            public uint DummyCount;
+            public uint ShapeCount;
+            public uint OtherNodesCount;
+            public uint TransformAnimationCount;
+            public uint UserPropertiesCount;
+        }
+
+        [DllImport(_contentTool, CharSet = CharSet.Ansi)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        private static extern bool ProbeData(string path, out HGRInfo info, out EntityInfo entities,
+            out ulong vertexCount, out ulong indexCount, StringBuilder textures, uint texturesSize);
+        public static bool ProbeHGR(string inputPath, out HGRInfo info, out EntityInfo entities,
+            out ulong vertexCount, out ulong indexCount, out string[] textures) {
+            var names = new StringBuilder(16 * 1024);
+            bool ok = ProbeData(inputPath, out info, out entities, out vertexCount, out indexCount, names, (uint)names.Capacity);
+            textures = ok && names.Length > 0 ? names.ToString().Split('\n') : new string[0];
+            return ok;
+        }
     }
 }
@@ -68,6 +68,20 @@ namespace KA3D_Tools
             }
         }
 
+        private bool _collectStats;
+        public bool CollectStats
+        {
+            get => _collectStats;
+            set
+            {
+                if (_collectStats != value)
+                {
+                    _collectStats = value;
+                    OnPropertyChanged(nameof(CollectStats));
+                }
+            }
+        }
+
         private bool _pathValid;
         public bool PathValid
         {
@@ -43,9 +43,11 @@ namespace KA3D_Tools
                 Debug.Assert(!string.IsNullOrEmpty(dlg.FileName));
                 // read the file
                 var vm = DataContext as HGR;
+                ContentToolAPI.EnableHGRStats(vm.CollectStats);
                 if (ContentToolAPI.StoreHGR(dlg.FileName, vm.TexturePath, vm.OutputPath)) {
                     vm.Data += dlg.FileName + "\n";
                 }
+                AppendStats(vm, dlg.FileName);
 
                 MessageBox.Show("Conversion Completed : " + dlg.FileName.Substring(dlg.FileName.LastIndexOf("\\") + 1, dlg.FileName.Length - dlg.FileName.LastIndexOf("\\") - 1));
             }
@@ -57,10 +59,23 @@ namespace KA3D_Tools
             string[] files = Directory.GetFiles(vm.InputPath, "*.hgr", SearchOption.TopDirectoryOnly);
             Directory.CreateDirectory(vm.OutputPath);
 
-            foreach (var hgr in files) {
-                if (ContentToolAPI.StoreHGR(hgr, vm.TexturePath, vm.OutputPath)) {
-                    vm.Data += hgr + "\n";
+            ContentToolAPI.EnableHGRStats(vm.CollectStats);
+            ContentToolAPI.StoreHGRBatch(files, vm.TexturePath, vm.OutputPath, out bool[] status, out double[] seconds);
+            for (int i = 0; i < files.Length; ++i) {
+                if (status[i]) {
+                    vm.Data += files[i] + " (" + seconds[i].ToString("0.00") + "s)\n";
                 }
+                AppendStats(vm, files[i]);
+            }
+        }
+
+        // Shows the timings and counters ContentTool collected for the file, if stats are on
+        private void AppendStats(HGR vm, string file)
+        {
+            if (!vm.CollectStats) return;
+            string stats = ContentToolAPI.GetHGRStats(file);
+            if (stats != null) {
+                vm.Data += "    " + stats + "\n";
             }
         }
 